@@ -0,0 +1,665 @@
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <math.h>
+#include <pthread.h>
+
+#define IMHUI_IMPLEMENTATION
+#include "imhui.h"
+
+#define DISPLAY_WIDTH 800
+#define DISPLAY_HEIGHT 600
+#define PADDING 10.0f
+#define WARMUP_FRAMES 10
+
+typedef size_t (*Bench_Frame)(ImHui *imhui);
+
+typedef struct {
+    const char *name;
+    Bench_Frame frame;
+    size_t frames;
+} Bench_Scene;
+
+static size_t bench_grid(ImHui *imhui, size_t rows, size_t cols)
+{
+    imhui_begin(imhui, vec2(0.0f, 0.0f), PADDING);
+    for (size_t i = 0; i < rows; ++i) {
+        imhui_layout_begin(imhui, IMHUI_HORZ_LAYOUT, PADDING);
+        for (size_t j = 0; j < cols; ++j) {
+            imhui_button(imhui, "Button", i * cols + j + 1);
+        }
+        imhui_layout_end(imhui);
+    }
+    imhui_end(imhui);
+    return rows * cols;
+}
+
+static size_t bench_grid_10x5(ImHui *imhui)
+{
+    return bench_grid(imhui, 10, 5);
+}
+
+static size_t bench_grid_10k(ImHui *imhui)
+{
+    return bench_grid(imhui, 100, 100);
+}
+
+static size_t bench_grid_100k(ImHui *imhui)
+{
+    return bench_grid(imhui, 1000, 100);
+}
+
+// The same grid with the IDs derived from the scope of every row instead of the caller
+static size_t bench_scoped_grid(ImHui *imhui, bool check_ids)
+{
+    const size_t ROWS = 100;
+    const size_t COLS = 100;
+    imhui->check_ids = check_ids;
+    imhui_begin(imhui, vec2(0.0f, 0.0f), PADDING);
+    for (size_t i = 0; i < ROWS; ++i) {
+        imhui_push_id_index(imhui, i);
+        imhui_layout_begin(imhui, IMHUI_HORZ_LAYOUT, PADDING);
+        for (size_t j = 0; j < COLS; ++j) {
+            imhui_button(imhui, "Button", imhui_id_index(imhui, j));
+        }
+        imhui_layout_end(imhui);
+        imhui_pop_id(imhui);
+    }
+    imhui_end(imhui);
+    imhui->check_ids = false;
+    assert(imhui->stats.duplicate_ids == 0);
+    return ROWS * COLS;
+}
+
+static size_t bench_grid_10k_scoped(ImHui *imhui)
+{
+    return bench_scoped_grid(imhui, false);
+}
+
+static size_t bench_grid_10k_checked(ImHui *imhui)
+{
+    return bench_scoped_grid(imhui, true);
+}
+
+// Lookups of the retained state of 100k live widgets. A hundred of them are replaced
+// every frame, so the old ones keep getting collected and their blocks reused.
+static size_t bench_state_100k(ImHui *imhui)
+{
+    typedef struct {
+        size_t visits;
+        float scroll;
+    } Bench_State;
+
+    const size_t WIDGETS = 100 * 1000;
+    const size_t CHURN = 100;
+    static size_t frame = 0;
+    frame += 1;
+
+    imhui_begin(imhui, vec2(0.0f, 0.0f), PADDING);
+    for (size_t i = 0; i < WIDGETS; ++i) {
+        Bench_State *state = imhui_state(imhui, imhui_id_index(imhui, frame * CHURN + i), sizeof(*state));
+        state->visits += 1;
+        state->scroll += 1.0f;
+    }
+    imhui_end(imhui);
+    return WIDGETS;
+}
+
+// Labels as long as the lines of a log pane
+static size_t bench_long_labels(ImHui *imhui)
+{
+    static const char LABEL[] =
+        "[12:34:56.789] INFO: rebuilt the layout of the main window in 0.42 ms, "
+        "uploaded 1234 vertices and 617 triangles";
+
+    imhui_begin(imhui, vec2(0.0f, 0.0f), PADDING);
+    for (size_t i = 0; i < 50; ++i) {
+        imhui_button(imhui, LABEL, i + 1);
+    }
+    imhui_end(imhui);
+    return 50;
+}
+
+// The same labels with every glyph looked up in the runtime atlas. Nothing is rasterized
+// after the first frame, so this is the steady state cost of the lookups.
+static size_t bench_long_labels_atlas(ImHui *imhui)
+{
+    imhui->atlas.rasterize = imhui_font_rasterize;
+    return bench_long_labels(imhui);
+}
+
+// Labels with units, names and arrows outside of ASCII, decoded from UTF-8 every frame
+static size_t bench_long_labels_utf8(ImHui *imhui)
+{
+    static const char LABEL[] =
+        "[12:34:56.789] INFO: pump \xE2\x84\x96" "3 \xE2\x86\x92 62.5 \xC2\xB0" "C, 1.2 \xC2\xB5s, "
+        "J\xC3\xBCrgen \xC3\x98stergaard \xE2\x86\x92 \xCE\x94p 0.42 bar";
+
+    imhui->atlas.rasterize = imhui_font_rasterize;
+    imhui_begin(imhui, vec2(0.0f, 0.0f), PADDING);
+    for (size_t i = 0; i < 50; ++i) {
+        imhui_button(imhui, LABEL, i + 1);
+    }
+    imhui_end(imhui);
+    return 50;
+}
+
+// A long list scrolled through a panel. Only the handful of visible buttons should get tessellated.
+static size_t bench_scrolled_list(ImHui *imhui)
+{
+    const size_t BUTTONS = 10 * 1000;
+    const float row_height = IMHUI_BUTTON_SIZE.y + PADDING;
+    static size_t frame = 0;
+    frame += 1;
+    const float scroll = (float) (frame * 7 % (size_t) (BUTTONS * row_height));
+
+    imhui_begin(imhui, vec2(0.0f, 0.0f), PADDING);
+    imhui_panel_begin(imhui, vec2(DISPLAY_WIDTH, DISPLAY_HEIGHT), scroll, PADDING);
+    for (size_t i = 0; i < BUTTONS; ++i) {
+        imhui_button(imhui, "Button", i + 1);
+    }
+    imhui_panel_end(imhui);
+    imhui_end(imhui);
+    return BUTTONS;
+}
+
+// The same kind of list as scrolled_list, but with 50k rows of 5 buttons walked through
+// a clipper. The cost of a frame should depend only on the rows that are visible.
+static size_t bench_clipped_table(ImHui *imhui)
+{
+    const size_t ROWS = 50 * 1000;
+    const size_t COLS = 5;
+    const float row_height = IMHUI_BUTTON_SIZE.y + PADDING;
+    static size_t frame = 0;
+    frame += 1;
+    const float scroll = (float) (frame * 7 % (size_t) (ROWS * row_height));
+
+    size_t widgets = 0;
+    imhui_begin(imhui, vec2(0.0f, 0.0f), PADDING);
+    imhui_panel_begin(imhui, vec2(DISPLAY_WIDTH, DISPLAY_HEIGHT), scroll, PADDING);
+    ImHui_Clipper clipper;
+    imhui_clipper_begin(imhui, &clipper, ROWS, 0.0f);
+    while (imhui_clipper_step(imhui, &clipper)) {
+        for (size_t i = clipper.first; i < clipper.last; ++i) {
+            imhui_layout_begin(imhui, IMHUI_HORZ_LAYOUT, PADDING);
+            for (size_t j = 0; j < COLS; ++j) {
+                imhui_button(imhui, "Button", i * COLS + j + 1);
+            }
+            imhui_layout_end(imhui);
+            widgets += COLS;
+        }
+    }
+    imhui_panel_end(imhui);
+    imhui_end(imhui);
+    return widgets;
+}
+
+typedef struct {
+    size_t lines;
+    char *data;
+    size_t size;
+    ImHui_Line_Index index;
+    size_t frame;
+    float scroll;
+} Bench_Document;
+
+static Bench_Document document_1k = {.lines = 1000};
+static Bench_Document document_1m = {.lines = 1000 * 1000};
+
+// Scrolls a log through a text view. The cost of a frame should not depend on the length of the log.
+static size_t bench_text_view(ImHui *imhui, Bench_Document *doc)
+{
+    if (doc->data == NULL) {
+        const size_t LINE_CAPACITY = 64;
+        doc->data = malloc(doc->lines * LINE_CAPACITY);
+        assert(doc->data != NULL);
+        for (size_t i = 0; i < doc->lines; ++i) {
+            doc->size += snprintf(doc->data + doc->size, LINE_CAPACITY,
+                                  "%zu: the quick brown fox jumps over the lazy dog\n", i);
+        }
+    }
+    imhui_line_index_update(imhui, &doc->index, doc->data, doc->size);
+
+    doc->frame += 1;
+    doc->scroll = (float) (doc->frame * 7 % doc->lines) * FONT_CHAR_HEIGHT * IMHUI_TEXT_SCALE;
+
+    imhui_begin(imhui, vec2(0.0f, 0.0f), PADDING);
+    imhui_text(imhui, "Log");
+    imhui_text_view(imhui, &doc->index, vec2(DISPLAY_WIDTH - 2 * PADDING, DISPLAY_HEIGHT - 100.0f), &doc->scroll);
+    imhui_end(imhui);
+    return 2;
+}
+
+static size_t bench_text_view_1k(ImHui *imhui)
+{
+    return bench_text_view(imhui, &document_1k);
+}
+
+static size_t bench_text_view_1m(ImHui *imhui)
+{
+    return bench_text_view(imhui, &document_1m);
+}
+
+static size_t bench_nested_tree_rec(ImHui *imhui, size_t depth, ImHui_ID *id)
+{
+    imhui_layout_begin(imhui, depth % 2 == 0 ? IMHUI_HORZ_LAYOUT : IMHUI_VERT_LAYOUT, PADDING);
+    imhui_button(imhui, "Node", (*id)++);
+    size_t widgets = 1;
+    if (depth > 0) {
+        widgets += bench_nested_tree_rec(imhui, depth - 1, id);
+        widgets += bench_nested_tree_rec(imhui, depth - 1, id);
+    }
+    imhui_layout_end(imhui);
+    return widgets;
+}
+
+static size_t bench_nested_tree(ImHui *imhui)
+{
+    ImHui_ID id = 1;
+    imhui_begin(imhui, vec2(0.0f, 0.0f), PADDING);
+    size_t widgets = bench_nested_tree_rec(imhui, 11, &id);
+    imhui_end(imhui);
+    return widgets;
+}
+
+static size_t bench_nested_chain(ImHui *imhui)
+{
+    const size_t DEPTH = 1000;
+    imhui_begin(imhui, vec2(0.0f, 0.0f), PADDING);
+    for (size_t i = 0; i < DEPTH; ++i) {
+        imhui_layout_begin(imhui, i % 2 == 0 ? IMHUI_HORZ_LAYOUT : IMHUI_VERT_LAYOUT, PADDING);
+        imhui_button(imhui, "Link", i + 1);
+    }
+    for (size_t i = 0; i < DEPTH; ++i) {
+        imhui_layout_end(imhui);
+    }
+    imhui_end(imhui);
+    return DEPTH;
+}
+
+// Rows of toolbars with a growing spacer between the tool buttons. After the first
+// frame every item is emitted straight at its cached slot, so nothing gets moved.
+static size_t bench_flex_toolbars(ImHui *imhui)
+{
+    const size_t ROWS = 100;
+    const size_t TOOLS = 6;
+    imhui_begin(imhui, vec2(0.0f, 0.0f), PADDING);
+    for (size_t row = 0; row < ROWS; ++row) {
+        imhui_flex_begin(imhui, imhui_id_index(imhui, row), (ImHui_Flex) {
+            .direction = IMHUI_HORZ_LAYOUT,
+            .size = vec2(DISPLAY_WIDTH, 0.0f),
+            .padding = PADDING,
+        });
+        for (size_t i = 0; i < TOOLS; ++i) {
+            if (i == TOOLS / 2) {
+                imhui_flex_item(imhui, (ImHui_Flex_Item) {.grow = 1.0f});
+            }
+            imhui_flex_item(imhui, (ImHui_Flex_Item) {.align = IMHUI_FLEX_CENTER});
+            imhui_button(imhui, "Tool", row * TOOLS + i + 1);
+        }
+        imhui_flex_end(imhui);
+    }
+    imhui_end(imhui);
+    return ROWS * TOOLS;
+}
+
+// The 100x100 grid with every row in a subtree, `changed` of the rows change every frame
+// and the rest are copied from the previous one.
+static size_t bench_subtree_grid(ImHui *imhui, size_t changed)
+{
+    const size_t ROWS = 100;
+    const size_t COLS = 100;
+    static uint64_t versions[100] = {0};
+    static size_t frame = 0;
+    for (size_t i = 0; i < changed; ++i) {
+        versions[(i + frame * changed) % ROWS] += 1;
+    }
+    frame += 1;
+
+    imhui_begin(imhui, vec2(0.0f, 0.0f), PADDING);
+    for (size_t i = 0; i < ROWS; ++i) {
+        if (imhui_subtree_begin(imhui, imhui_id_index(imhui, i), IMHUI_HORZ_LAYOUT, PADDING, versions[i])) {
+            for (size_t j = 0; j < COLS; ++j) {
+                imhui_button(imhui, "Button", i * COLS + j + 1);
+            }
+        }
+        imhui_subtree_end(imhui);
+    }
+    imhui_end(imhui);
+    return ROWS * COLS;
+}
+
+static size_t bench_subtree_grid_0(ImHui *imhui)
+{
+    return bench_subtree_grid(imhui, 0);
+}
+
+static size_t bench_subtree_grid_1(ImHui *imhui)
+{
+    return bench_subtree_grid(imhui, 1);
+}
+
+static size_t bench_subtree_grid_10(ImHui *imhui)
+{
+    return bench_subtree_grid(imhui, 10);
+}
+
+static size_t bench_subtree_grid_100(ImHui *imhui)
+{
+    return bench_subtree_grid(imhui, 100);
+}
+
+static Bench_Scene scenes[] = {
+    {.name = "grid_10x5",    .frame = bench_grid_10x5,    .frames = 20000},
+    {.name = "grid_10k",     .frame = bench_grid_10k,     .frames = 200},
+    {.name = "grid_100k",    .frame = bench_grid_100k,    .frames = 20},
+    {.name = "grid_10k_scoped",  .frame = bench_grid_10k_scoped,  .frames = 200},
+    {.name = "grid_10k_checked", .frame = bench_grid_10k_checked, .frames = 200},
+    {.name = "state_100k",   .frame = bench_state_100k,   .frames = 200},
+    {.name = "long_labels",  .frame = bench_long_labels,  .frames = 5000},
+    {.name = "long_labels_atlas", .frame = bench_long_labels_atlas, .frames = 5000},
+    {.name = "long_labels_utf8", .frame = bench_long_labels_utf8, .frames = 5000},
+    {.name = "scrolled_list", .frame = bench_scrolled_list, .frames = 200},
+    {.name = "clipped_table", .frame = bench_clipped_table, .frames = 20000},
+    {.name = "text_view_1k", .frame = bench_text_view_1k, .frames = 5000},
+    {.name = "text_view_1m", .frame = bench_text_view_1m, .frames = 5000},
+    {.name = "nested_tree",  .frame = bench_nested_tree,  .frames = 1000},
+    {.name = "nested_chain", .frame = bench_nested_chain, .frames = 2000},
+    {.name = "flex_toolbars", .frame = bench_flex_toolbars, .frames = 2000},
+    {.name = "subtree_grid_0",   .frame = bench_subtree_grid_0,   .frames = 200},
+    {.name = "subtree_grid_1",   .frame = bench_subtree_grid_1,   .frames = 200},
+    {.name = "subtree_grid_10",  .frame = bench_subtree_grid_10,  .frames = 200},
+    {.name = "subtree_grid_100", .frame = bench_subtree_grid_100, .frames = 200},
+};
+#define SCENES_COUNT (sizeof(scenes) / sizeof(scenes[0]))
+
+typedef struct {
+    const char *suffix;
+    bool vertex_cache;
+    bool instanced;
+} Bench_Mode;
+
+static Bench_Mode modes[] = {
+    {.suffix = ""},
+    {.suffix = "+cache",       .vertex_cache = true},
+    {.suffix = "+quads",       .instanced = true},
+    {.suffix = "+quads+cache", .vertex_cache = true, .instanced = true},
+};
+#define MODES_COUNT (sizeof(modes) / sizeof(modes[0]))
+
+// Sweeps the cursor over the display in a Lissajous curve and clicks
+// every 16 frames, so hot, active and clicked paths all get exercised.
+static void bench_script_input(ImHui *imhui, size_t frame)
+{
+    const float t = (float) frame * 0.05f;
+    imhui_mouse_move(
+        imhui,
+        (0.5f + 0.5f * sinf(3.0f * t)) * (float) imhui->width,
+        (0.5f + 0.5f * sinf(2.0f * t)) * (float) imhui->height);
+
+    if (frame % 16 == 0) {
+        imhui_mouse_down(imhui);
+    } else if (frame % 16 == 4) {
+        imhui_mouse_up(imhui);
+    }
+}
+
+static double bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+static int bench_compare_double(const void *a, const void *b)
+{
+    const double x = *(const double*) a;
+    const double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+static double bench_percentile(const double *sorted, size_t n, double p)
+{
+    size_t index = (size_t) (p * (double) (n - 1) + 0.5);
+    return sorted[index];
+}
+
+static size_t bench_allocations = 0;
+
+static void *bench_alloc(void *user, void *ptr, size_t old_size, size_t new_size)
+{
+    (void) user;
+    (void) old_size;
+    if (new_size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    bench_allocations += 1;
+    return realloc(ptr, new_size);
+}
+
+static ImHui imhui = {
+    .width = DISPLAY_WIDTH,
+    .height = DISPLAY_HEIGHT,
+    .allocator = {
+        .alloc = bench_alloc,
+    },
+};
+
+static void bench_run_scene(const Bench_Scene *scene, const Bench_Mode *mode)
+{
+    double *frame_ns = malloc(sizeof(*frame_ns) * scene->frames);
+    assert(frame_ns != NULL);
+
+    imhui.active = 0;
+    imhui.atlas.rasterize = NULL;
+    imhui.vertex_cache = mode->vertex_cache;
+    imhui.instanced = mode->instanced;
+    imhui_mouse_up(&imhui);
+
+    for (size_t i = 0; i < WARMUP_FRAMES; ++i) {
+        bench_script_input(&imhui, i);
+        scene->frame(&imhui);
+    }
+
+    const size_t allocations = bench_allocations;
+    size_t widgets = 0;
+    size_t cache_hits = 0;
+    size_t cache_lookups = 0;
+    size_t dirty_frames = 0;
+    double total_ns = 0.0;
+    for (size_t i = 0; i < scene->frames; ++i) {
+        bench_script_input(&imhui, WARMUP_FRAMES + i);
+        const double begin = bench_now_ns();
+        widgets = scene->frame(&imhui);
+        frame_ns[i] = bench_now_ns() - begin;
+        total_ns += frame_ns[i];
+        cache_hits += imhui.stats.cache_hits;
+        cache_lookups += imhui.stats.cache_hits + imhui.stats.cache_misses;
+        dirty_frames += imhui.dirty;
+    }
+
+    qsort(frame_ns, scene->frames, sizeof(*frame_ns), bench_compare_double);
+
+    const size_t bytes =
+        imhui.vertices_count * sizeof(imhui.vertices[0]) +
+        imhui.triangles_count * sizeof(imhui.triangles[0]) +
+        imhui.quads_count * sizeof(imhui.quads[0]);
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s%s", scene->name, mode->suffix);
+
+    printf("%-30s %9zu %7zu %10.2f %12zu %12zu %12zu %8zu %12zu %10.2f %10.2f %7zu %6.1f%% %6.1f%%\n",
+           name,
+           widgets,
+           scene->frames,
+           total_ns / (double) (scene->frames * widgets),
+           imhui.vertices_count,
+           imhui.triangles_count,
+           imhui.quads_count,
+           imhui.batches_count,
+           bytes,
+           bench_percentile(frame_ns, scene->frames, 0.50) / 1e3,
+           bench_percentile(frame_ns, scene->frames, 0.99) / 1e3,
+           bench_allocations - allocations,
+           cache_lookups > 0 ? 100.0 * (double) cache_hits / (double) cache_lookups : 0.0,
+           100.0 * (double) dirty_frames / (double) scene->frames);
+
+    free(frame_ns);
+}
+
+// Independent contexts, e.g. the panels of different monitors, built on worker threads at
+// the same time and merged into a single draw list on the main thread every frame.
+#define PARALLEL_CONTEXTS 8
+#define PARALLEL_FRAMES 100
+
+typedef struct {
+    pthread_t thread;
+    size_t index;
+    size_t threads;
+} Bench_Worker;
+
+// NOTE: the contexts use the default allocator, bench_alloc() is not thread safe
+static ImHui parallel_contexts[PARALLEL_CONTEXTS];
+static ImHui parallel_merged = {0};
+static pthread_barrier_t parallel_start;
+static pthread_barrier_t parallel_done;
+static bool parallel_quit = false;
+
+static void *bench_parallel_worker(void *arg)
+{
+    const Bench_Worker *worker = arg;
+    for (;;) {
+        pthread_barrier_wait(&parallel_start);
+        if (parallel_quit) {
+            break;
+        }
+        for (size_t i = worker->index; i < PARALLEL_CONTEXTS; i += worker->threads) {
+            bench_grid(&parallel_contexts[i], 100, 100);
+        }
+        pthread_barrier_wait(&parallel_done);
+    }
+    return NULL;
+}
+
+static double bench_run_parallel(size_t threads, double *merge_ns)
+{
+    Bench_Worker workers[PARALLEL_CONTEXTS];
+    assert(threads <= PARALLEL_CONTEXTS);
+
+    pthread_barrier_init(&parallel_start, NULL, threads + 1);
+    pthread_barrier_init(&parallel_done, NULL, threads + 1);
+    parallel_quit = false;
+    for (size_t i = 0; i < threads; ++i) {
+        workers[i] = (Bench_Worker) {
+            .index = i,
+            .threads = threads,
+        };
+        pthread_create(&workers[i].thread, NULL, bench_parallel_worker, &workers[i]);
+    }
+
+    ImHui *contexts[PARALLEL_CONTEXTS];
+    for (size_t i = 0; i < PARALLEL_CONTEXTS; ++i) {
+        contexts[i] = &parallel_contexts[i];
+    }
+
+    double frame_ns[PARALLEL_FRAMES];
+    *merge_ns = 0.0;
+    for (size_t i = 0; i < WARMUP_FRAMES + PARALLEL_FRAMES; ++i) {
+        const double begin = bench_now_ns();
+        pthread_barrier_wait(&parallel_start);
+        pthread_barrier_wait(&parallel_done);
+        const double merge_begin = bench_now_ns();
+        imhui_merge(&parallel_merged, contexts, PARALLEL_CONTEXTS);
+        const double end = bench_now_ns();
+        if (i >= WARMUP_FRAMES) {
+            frame_ns[i - WARMUP_FRAMES] = end - begin;
+            *merge_ns += end - merge_begin;
+        }
+    }
+    *merge_ns /= PARALLEL_FRAMES;
+
+    parallel_quit = true;
+    pthread_barrier_wait(&parallel_start);
+    for (size_t i = 0; i < threads; ++i) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    pthread_barrier_destroy(&parallel_start);
+    pthread_barrier_destroy(&parallel_done);
+
+    qsort(frame_ns, PARALLEL_FRAMES, sizeof(*frame_ns), bench_compare_double);
+    return bench_percentile(frame_ns, PARALLEL_FRAMES, 0.50);
+}
+
+static void bench_parallel(void)
+{
+    for (size_t i = 0; i < PARALLEL_CONTEXTS; ++i) {
+        parallel_contexts[i] = (ImHui) {
+            .width = DISPLAY_WIDTH,
+            .height = DISPLAY_HEIGHT,
+        };
+    }
+
+    printf("\n%ld core(s) online\n", sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%-30s %9s %9s %10s %12s %10s %10s\n",
+           "parallel", "threads", "contexts", "widgets", "p50 (us)", "merge (us)", "speedup");
+    double single_ns = 0.0;
+    for (size_t threads = 1; threads <= PARALLEL_CONTEXTS; threads *= 2) {
+        double merge_ns = 0.0;
+        const double ns = bench_run_parallel(threads, &merge_ns);
+        if (threads == 1) {
+            single_ns = ns;
+        }
+        printf("%-30s %9zu %9d %10d %12.2f %10.2f %9.2fx\n",
+               "grid_10k", threads, PARALLEL_CONTEXTS, PARALLEL_CONTEXTS * 100 * 100,
+               ns / 1e3, merge_ns / 1e3, single_ns / ns);
+    }
+
+    for (size_t i = 0; i < PARALLEL_CONTEXTS; ++i) {
+        imhui_free(&parallel_contexts[i]);
+    }
+    imhui_free(&parallel_merged);
+}
+
+int main(int argc, char **argv)
+{
+    printf("sizeof(ImHui) = %zu bytes, sizeof(Vertex) = %zu bytes, sizeof(Triangle) = %zu bytes, sizeof(Quad) = %zu bytes\n",
+           sizeof(ImHui), sizeof(Vertex), sizeof(Triangle), sizeof(Quad));
+    printf("%-30s %9s %7s %10s %12s %12s %12s %8s %12s %10s %10s %7s %7s %7s\n",
+           "scene", "widgets", "frames", "ns/widget",
+           "verts/frame", "tris/frame", "quads/frame", "batches", "bytes/frame",
+           "p50 (us)", "p99 (us)", "allocs", "hits", "dirty");
+
+    for (size_t i = 0; i < SCENES_COUNT; ++i) {
+        bool selected = argc <= 1;
+        for (int j = 1; j < argc && !selected; ++j) {
+            selected = strcmp(argv[j], scenes[i].name) == 0;
+        }
+
+        if (selected) {
+            for (size_t j = 0; j < MODES_COUNT; ++j) {
+                bench_run_scene(&scenes[i], &modes[j]);
+            }
+        }
+    }
+
+    bool parallel = argc <= 1;
+    for (int j = 1; j < argc && !parallel; ++j) {
+        parallel = strcmp(argv[j], "parallel") == 0;
+    }
+    if (parallel) {
+        bench_parallel();
+    }
+
+    imhui_line_index_free(&imhui, &document_1k.index);
+    imhui_line_index_free(&imhui, &document_1m.index);
+    free(document_1k.data);
+    free(document_1m.data);
+    imhui_free(&imhui);
+
+    return 0;
+}
@@ -1,7 +1,11 @@
 #ifndef IMHUI_H_
 #define IMHUI_H_
 
+#include <float.h>
+#include <limits.h>
+#include <stdatomic.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 
 // NOTE: color scheme is stolen from https://visme.co/blog/website-color-schemes/
@@ -538,9 +542,17 @@ const unsigned char FONT[FONT_WIDTH * FONT_HEIGHT] = {
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
 };
 
-#define VERTICES_CAPACITY (1024 * 32)
-#define TRIANGLES_CAPACITY (1024 * 32)
-#define LAYOUT_STACK_CAPACITY 1024
+// NOTE: the minimal capacity of the growable frame buffers. They are never shrunk,
+// so after the first few frames the steady state does not allocate at all.
+#define IMHUI_INITIAL_CAPACITY 256
+#define IMHUI_TEXT_CACHE_MAX_AGE 60
+// NOTE: the size of the retained state of a widget, see imhui_state(). The blocks are
+// allocated in pages, so the address of a block never changes while the widget is alive.
+#define IMHUI_STATE_SIZE 64
+#define IMHUI_STATE_PAGE_BLOCKS 256
+#define IMHUI_STATE_MAX_AGE 60
+
+#define IMHUI_SWAP(type, a, b) do { type t = (a); (a) = (b); (b) = t; } while (0)
 
 #define IMHUI_BUTTON_SIZE vec2(100.0f, 50.0f)
 #define IMHUI_BUTTON_COLOR rgba(HEXCOLOR(0x5CDB95FF))
@@ -551,6 +563,10 @@ const unsigned char FONT[FONT_WIDTH * FONT_HEIGHT] = {
 #define IMHUI_BUTTON_TEXT_COLOR rgba(HEXCOLOR(BACKGROUND_COLOR_HEX))
 #define IMHUI_BUTTON_OFFSET vec2(2.0f, 2.0f)
 #define IMHUI_PADDING 10.0f
+#define IMHUI_TEXT_SCALE 2.0f
+#define IMHUI_TEXT_COLOR rgba(HEXCOLOR(0xEDF5E1FF))
+#define IMHUI_TEXT_VIEW_COLOR rgba(HEXCOLOR(0x379683FF))
+#define IMHUI_TEXT_VIEW_SCROLL_LINES 3.0f
 
 #define VEC2_COUNT 2
 
@@ -583,6 +599,50 @@ RGBA rgba(float r, float g, float b, float a)
     };
 }
 
+// NOTE: the packing is on the hot path of the tessellation. Only the positions
+// are clamped, since the scrolled content may legitimately end up outside of the
+// int16 range. The colors and the UVs are expected to be within [0, 1].
+static int16_t imhui_pack_pixel(float x)
+{
+    x = x < -32768.0f ? -32768.0f : x;
+    x = x > 32767.0f ? 32767.0f : x;
+    // Rounds to the nearest by truncating a value shifted into the positive range
+    return (int16_t) ((int32_t) (x + 32768.5f) - 32768);
+}
+
+static uint8_t imhui_pack_unorm8(float x)
+{
+    return (uint8_t) (int32_t) (x * 255.0f + 0.5f);
+}
+
+static uint16_t imhui_pack_unorm16(float x)
+{
+    return (uint16_t) (int32_t) (x * 65535.0f + 0.5f);
+}
+
+#ifdef IMHUI_PACKED_VERTICES
+// 12 bytes instead of 32. Positions are whole pixels, colors are unorm8 and
+// UVs are unorm16, so the backend has to use the normalized integer attributes.
+typedef struct {
+    int16_t position[2];
+    uint8_t color[4];
+    uint16_t uv[2];
+} Vertex;
+
+Vertex vertex(Vec2 position, RGBA color, Vec2 uv)
+{
+    return (Vertex) {
+        .position = {imhui_pack_pixel(position.x), imhui_pack_pixel(position.y)},
+        .color = {
+            imhui_pack_unorm8(color.r),
+            imhui_pack_unorm8(color.g),
+            imhui_pack_unorm8(color.b),
+            imhui_pack_unorm8(color.a),
+        },
+        .uv = {imhui_pack_unorm16(uv.x), imhui_pack_unorm16(uv.y)},
+    };
+}
+#else
 typedef struct {
     Vec2 position;
     RGBA color;
@@ -597,14 +657,57 @@ Vertex vertex(Vec2 position, RGBA color, Vec2 uv)
         .uv = uv,
     };
 }
+#endif // IMHUI_PACKED_VERTICES
+
+// One instance of a textured quad for the instanced rendering mode (20 bytes
+// instead of 4 vertices and 2 triangles). The backend draws a unit quad for each of them.
+typedef struct {
+    int16_t rect[4];            // x, y, w, h in pixels
+    uint16_t uv[4];             // x, y, w, h in unorm16
+    uint8_t color[4];           // unorm8
+} Quad;
+
+Quad quad(Vec2 p, Vec2 s, RGBA color, Vec2 uv_p, Vec2 uv_s)
+{
+    return (Quad) {
+        .rect = {
+            imhui_pack_pixel(p.x),
+            imhui_pack_pixel(p.y),
+            imhui_pack_pixel(s.x),
+            imhui_pack_pixel(s.y),
+        },
+        .uv = {
+            imhui_pack_unorm16(uv_p.x),
+            imhui_pack_unorm16(uv_p.y),
+            imhui_pack_unorm16(uv_s.x),
+            imhui_pack_unorm16(uv_s.y),
+        },
+        .color = {
+            imhui_pack_unorm8(color.r),
+            imhui_pack_unorm8(color.g),
+            imhui_pack_unorm8(color.b),
+            imhui_pack_unorm8(color.a),
+        },
+    };
+}
 
 #define TRIANGLE_COUNT 3
 
+#ifdef IMHUI_INDEX16
+// Halves the index bandwidth. A frame with more than 65536 vertices is split
+// into several batches, each of them is indexed relative to its own base vertex.
+typedef uint16_t ImHui_Index;
+#define IMHUI_INDEX_MAX UINT16_MAX
+#else
+typedef unsigned int ImHui_Index;
+#define IMHUI_INDEX_MAX UINT_MAX
+#endif // IMHUI_INDEX16
+
 typedef struct {
-    unsigned int a, b, c;
+    ImHui_Index a, b, c;
 } Triangle;
 
-Triangle triangle(unsigned int a, unsigned int b, unsigned int c)
+Triangle triangle(ImHui_Index a, ImHui_Index b, ImHui_Index c)
 {
     return (Triangle) {
         .a = a,
@@ -617,287 +720,3027 @@ typedef enum {
     BUTTON_LEFT = 1,
 } Buttons;
 
-typedef int ImHui_ID;
+// 0 is never a valid ID, it means "no widget". The IDs are usually derived with
+// imhui_id() or imhui_id_index() from the scopes pushed with imhui_push_id().
+typedef uint64_t ImHui_ID;
+
+typedef enum {
+    IMHUI_BUTTON_IDLE = 0,
+    IMHUI_BUTTON_HOT,
+    IMHUI_BUTTON_ACTIVE,
+} ImHui_Button_State;
 
 typedef enum {
     IMHUI_VERT_LAYOUT,
     IMHUI_HORZ_LAYOUT,
 } ImHui_Layout_Type;
 
+#define IMHUI_LAYOUT_NONE ((size_t) -1)
+
+// The layouts of a frame as parallel arrays indexed by node. The nodes are in the order
+// the layouts began, so every subtree is a contiguous range. The tree of the previous
+// frame is kept, and the clean subtrees are copied over from it, see imhui_subtree_begin().
 typedef struct {
-    ImHui_Layout_Type type;
-    Vec2 start;
+    ImHui_Layout_Type *type;
+    Vec2 *start;
+    Vec2 *size;
+    float *padding;
+    size_t *parent;             // IMHUI_LAYOUT_NONE for the root
+    size_t *first_child;
+    size_t *next_sibling;       // NOTE: the last child instead, while the node is not ended yet
+    ImHui_ID *subtree;          // the ID of the subtree the node is the root of, or 0
+    // The items of a flex container: `start` is the slot of the current item
+    // and `size` is what its widget took.
+    bool *flex;
+    size_t count;
+    size_t capacity;
+} ImHui_Layout_Tree;
+
+typedef enum {
+    IMHUI_FLEX_START = 0,
+    IMHUI_FLEX_CENTER,
+    IMHUI_FLEX_END,
+    IMHUI_FLEX_STRETCH,         // cross axis only: the slot takes the whole cross size of the container
+    IMHUI_FLEX_SPACE_BETWEEN,   // main axis only: the free space goes between the items
+} ImHui_Flex_Align;
+
+typedef struct {
+    ImHui_Layout_Type direction;
+    // 0 along an axis fits the container to its items along that axis
+    Vec2 size;
+    float padding;
+    // Where the space left after growing the items goes along the main axis
+    ImHui_Flex_Align justify;
+} ImHui_Flex;
+
+// NOTE: zero initialized item takes exactly the size of its widget and neither grows nor shrinks
+typedef struct {
+    float grow;
+    float shrink;
+    float basis;                // the main size before growing and shrinking, 0 is the measured size
+    float min, max;             // of the main size, max of 0 is unbounded
+    ImHui_Flex_Align align;     // along the cross axis
+} ImHui_Flex_Item;
+
+typedef struct {
+    ImHui_Flex_Item item;
+    Vec2 position;              // where the widget was emitted
+    Vec2 measured;              // the size the widget took
+    float basis;                // scratch of the resolution
+    float main_size;
+    bool frozen;
+    size_t nodes_first;
+    size_t vertices_first;
+    size_t quads_first;
+    size_t hit_rects_first;
+} ImHui_Flex_Record;
+
+typedef struct {
+    ImHui_ID id;
+    ImHui_Flex flex;
+    Vec2 position;
+    size_t first_item;          // in `flex_items`
+} ImHui_Flex_Container;
+
+// Allocator hook with the semantics of realloc(). new_size == 0 means free.
+// old_size is provided for the allocators that do not track the sizes themselves.
+typedef void *(*ImHui_Alloc)(void *user, void *ptr, size_t old_size, size_t new_size);
+
+typedef struct {
+    ImHui_Alloc alloc;
+    void *user;
+} ImHui_Allocator;
+
+// Pixels within [x0, x1) x [y0, y1)
+typedef struct {
+    float x0, y0, x1, y1;
+} ImHui_Clip;
+
+// Handle of a texture defined by the backend. 0 is the font texture of the backend.
+typedef uintptr_t ImHui_Texture;
+
+typedef struct ImHui ImHui;
+typedef struct ImHui_Batch ImHui_Batch;
+
+typedef void (*ImHui_Draw_Callback)(const ImHui *imhui, const ImHui_Batch *batch);
+
+// A draw command: consecutive triangles whose indices are relative to `base_vertex`,
+// or consecutive quads in the instanced mode, that share the same state. The backends
+// draw each of them with glDrawElementsBaseVertex() or similar, scissored to `clip`
+// and sampling `texture`. The batches with a `callback` have no geometry, the
+// backends call it at that point of the frame instead.
+struct ImHui_Batch {
+    size_t base_vertex;
+    size_t first_triangle;
+    size_t triangles_count;
+    size_t first_quad;
+    size_t quads_count;
+    ImHui_Clip clip;
+    ImHui_Texture texture;
+    ImHui_Draw_Callback callback;
+    void *user;
+};
+
+// Open addressing hash table with linear probing. Every slot starts with
+// ImHui_Slot, the rest of the slot is owned by the user of the table.
+typedef struct {
+    uint64_t key;               // 0 marks an empty slot
+    size_t frame;               // the last frame the slot was touched at
+} ImHui_Slot;
+
+typedef struct {
+    char *slots;
+    size_t slot_size;
+    size_t capacity;            // always a power of two
+    size_t count;
+    size_t touched;             // slots touched since the last sweep
+} ImHui_Table;
+
+// Tessellation of a button recorded at `slot.frame`. It is reused on the next
+// frame if the label, the position, the clip rect and the hot/active state did not change.
+typedef struct {
+    ImHui_Slot slot;
+    uint64_t label_hash;
+    Vec2 position;
+    ImHui_Clip clip;
+    ImHui_Button_State state;
+    bool instanced;
+    size_t vertices_first;
+    size_t vertices_count;
+    size_t index_first;         // index of the first vertex relative to its batch
+    size_t triangles_first;
+    size_t triangles_count;
+    size_t quads_first;
+    size_t quads_count;
+} ImHui_Button_Cache;
+
+// Measured text metrics, keyed by the hash and the length of the text and
+// evicted after IMHUI_TEXT_CACHE_MAX_AGE frames without a lookup.
+typedef struct {
+    ImHui_Slot slot;
+    uint64_t hash;
+    size_t length;
+    size_t glyphs;
+    size_t lines;
+    size_t columns;
+} ImHui_Text_Cache;
+
+// The slot of a flex item resolved by imhui_flex_end(), keyed by the ID of the
+// container and the index of the item. The next frame places the item right away.
+typedef struct {
+    ImHui_Slot slot;
+    Vec2 offset;                // relative to the container
     Vec2 size;
+} ImHui_Flex_Cache;
+
+// A subtree recorded at `built` by imhui_subtree_begin(), and where its nodes, geometry and
+// hit rects ended up on the frame `slot.frame`. It is copied over to the next frame
+// if the version, the position and the clip rect did not change.
+typedef struct {
+    ImHui_Slot slot;
+    uint64_t version;
+    ImHui_Layout_Type type;
     float padding;
-} ImHui_Layout;
+    Vec2 start;
+    ImHui_Clip clip;
+    bool instanced;
+    bool reusable;              // nothing was hot or active, no draw callbacks and the vertices fit into ImHui_Index
+    size_t built;
+    size_t nodes_first;
+    size_t nodes_count;
+    size_t vertices_first;
+    size_t vertices_count;
+    size_t triangles_first;
+    size_t triangles_count;
+    size_t quads_first;
+    size_t quads_count;
+    size_t hit_rects_first;
+    size_t hit_rects_count;
+} ImHui_Subtree_Cache;
+
+typedef struct {
+    ImHui_ID id;
+    uint64_t version;
+    ImHui_ID active;            // at the beginning of the subtree
+    bool reused;
+    size_t node;
+    size_t batches_first;
+    size_t base_vertex;         // of the batch the subtree begins in
+    size_t vertices_first;
+    size_t triangles_first;
+    size_t quads_first;
+    size_t hit_rects_first;
+} ImHui_Subtree;
+
+// Retained state of a widget, collected after IMHUI_STATE_MAX_AGE frames without a lookup.
+// The table only holds a pointer to the block, which lives in one of the pages of `state_pages`.
+// The slots move as the table grows and shrinks, the blocks stay where they are, so the address
+// returned by imhui_state() remains valid. A lookup touches the slot and then the block.
+typedef struct {
+    ImHui_Slot slot;
+    void *block;                // IMHUI_STATE_SIZE bytes in one of `state_pages`
+} ImHui_State_Entry;
+
+// The text is UTF-8. '\n' starts a new line, every other codepoint is a glyph.
+typedef struct {
+    size_t length;              // in bytes
+    size_t glyphs;
+    size_t lines;
+    Vec2 size;                  // in pixels at the requested scale
+    uint64_t hash;              // FNV-1a of the bytes
+} ImHui_Text_Metrics;
+
+// Offsets of the beginnings of the lines of a caller owned text, e.g. a
+// memory mapped file or a log that keeps growing. The text is never copied.
+typedef struct {
+    const char *data;
+    size_t size;                // bytes indexed so far
+    size_t *lines;              // lines[i] is the offset of the line i
+    size_t lines_count;
+    size_t lines_capacity;
+} ImHui_Line_Index;
+
+// Walks only the visible rows of a long list or grid laid out in a vertical layout:
+//
+//     ImHui_Clipper clipper;
+//     imhui_clipper_begin(imhui, &clipper, rows_count, 0.0f);
+//     while (imhui_clipper_step(imhui, &clipper)) {
+//         for (size_t i = clipper.first; i < clipper.last; ++i) {
+//             ... row i ...
+//         }
+//     }
+//
+// The layout is advanced over the skipped rows as if they were there.
+typedef struct {
+    size_t rows_count;
+    bool measure;               // the advance is measured on the first row
+    float advance;              // row height plus the padding of the layout
+    float start;                // y of the first row
+    size_t step;
+    size_t first, last;         // the rows to emit in the current step
+} ImHui_Clipper;
+
+// The part of a widget inside of its clip rect, recorded for the hover resolution
+typedef struct {
+    ImHui_ID id;
+    ImHui_Clip rect;
+} ImHui_Hit_Rect;
+
+typedef struct {
+    size_t cache_hits;
+    size_t cache_misses;
+    size_t duplicate_ids;       // only counted with `check_ids`
+    size_t subtrees_reused;
+    size_t subtrees_built;
+} ImHui_Stats;
+
+// Rasterizes the glyph of `codepoint` into a zeroed `width` x `height` cell of 8 bit
+// coverage with `stride` bytes per row, e.g. with stbtt_MakeCodepointBitmap() of stb_truetype.
+typedef void (*ImHui_Glyph_Rasterizer)(void *user, uint32_t codepoint,
+                                       size_t width, size_t height,
+                                       uint8_t *pixels, size_t stride);
+
+#define IMHUI_ATLAS_WIDTH 512
+#define IMHUI_ATLAS_HEIGHT 512
+
+typedef struct {
+    size_t y, height;
+    size_t x;                   // the first free column
+} ImHui_Atlas_Shelf;
+
+// The glyphs of one cell size, indexed by a two level table: the high bits of the
+// codepoint pick a page of IMHUI_GLYPH_PAGE_SIZE glyphs, the low bits the glyph.
+// The pages are only allocated for the blocks of Unicode that are actually used.
+typedef struct ImHui_Glyph_Page ImHui_Glyph_Page;
+
+typedef struct {
+    size_t width, height;
+    ImHui_Glyph_Page **pages;   // IMHUI_GLYPH_PAGES of them, NULL until used
+} ImHui_Atlas_Size;
+
+// Runtime glyph atlas that replaces FONT as the texture 0. Every glyph is rasterized the
+// first time it is seen at a size, at exactly that size, and packed into the shelves.
+// When the atlas runs full it is rebuilt on the next frame with only the glyphs still in use.
+typedef struct {
+    // NULL keeps the text on the static FONT texture
+    ImHui_Glyph_Rasterizer rasterize;
+    void *user;
+
+    uint8_t *pixels;            // IMHUI_ATLAS_WIDTH x IMHUI_ATLAS_HEIGHT coverage
+    ImHui_Atlas_Size *sizes;
+    size_t sizes_count;
+    size_t sizes_capacity;
+    ImHui_Atlas_Shelf *shelves;
+    size_t shelves_count;
+    size_t shelves_capacity;
+
+    // The texels changed by the current frame. The backends upload them after imhui_end(),
+    // imhui_begin() starts over. Empty when x0 == x1.
+    size_t dirty_x0, dirty_y0, dirty_x1, dirty_y1;
+
+    bool active;                // `pixels` is the texture 0 of the current frame
+    bool full;                  // some glyph did not fit into the current frame
+} ImHui_Atlas;
+
+// Signed distance field font made by sdfgen.c. One atlas of the distances to the outlines
+// is sampled with the bilinear filtering and thresholded by the fragment shader, so the
+// text stays crisp at any scale without rasterizing every size.
+//
+// The file is little endian: IMHUI_SDF_MAGIC, then the u32 version, width, height,
+// cell_width, cell_height, padding, spread, first, count and columns, then width * height
+// bytes of the distances. The cells of the codepoints [first, first + count) and of the
+// solid rect after them go row by row, `columns` of them per row, with `padding` texels
+// around every cell. The distances map [-spread, spread] texels onto [0, 255] with the
+// outline at 128, the positive ones inside of the glyph.
+#define IMHUI_SDF_MAGIC "ISDF"
+#define IMHUI_SDF_VERSION 1
+#define IMHUI_SDF_HEADER_SIZE (4 + 10 * 4)
+
+typedef struct ImHui_Glyph_UV ImHui_Glyph_UV;
+
+typedef struct {
+    size_t width, height;
+    const uint8_t *pixels;      // points into the loaded data
+    size_t cell_width, cell_height;
+    size_t padding;
+    float spread;
+    uint32_t first, count;
+    size_t columns;
+    ImHui_Glyph_UV *uvs;        // count + 1 of them, the last one is the solid rect
+} ImHui_Sdf_Font;
+
+typedef enum {
+    IMHUI_INPUT_MOUSE_MOVE = 0,
+    IMHUI_INPUT_MOUSE_DOWN,
+    IMHUI_INPUT_MOUSE_UP,
+    IMHUI_INPUT_MOUSE_SCROLL,
+} ImHui_Input_Type;
+
+typedef struct {
+    ImHui_Input_Type type;
+    double time;                // in seconds, on whatever clock the producer uses
+    Vec2 pos;                   // IMHUI_INPUT_MOUSE_MOVE only
+    float dy;                   // IMHUI_INPUT_MOUSE_SCROLL only
+} ImHui_Input_Event;
+
+#define IMHUI_INPUT_QUEUE_CAPACITY 256
 
+// Single producer single consumer lock free ring of the input events, owned by the
+// application and attached to ImHui::input. Any one thread (e.g. the one that polls the
+// window system or a network connection) pushes the events with imhui_input_push(),
+// imhui_begin() consumes them. The indices keep growing and are wrapped only on the access.
+// The padding keeps them on separate cache lines.
+//
+// A move pushed right after another move that is not consumed yet replaces it, so the
+// moves never fill the ring up and there is always room for the button transitions.
+// `busy` guards that one slot while either side touches it. Neither side waits on it:
+// the producer appends a new event instead and the consumer stops until the next frame.
 typedef struct {
+    atomic_size_t head;         // written only by the consumer
+    char head_padding[64 - sizeof(atomic_size_t)];
+    atomic_size_t tail;         // written only by the producer
+    char tail_padding[64 - sizeof(atomic_size_t)];
+    atomic_bool busy[IMHUI_INPUT_QUEUE_CAPACITY];
+    ImHui_Input_Event events[IMHUI_INPUT_QUEUE_CAPACITY];
+} ImHui_Input_Queue;
+
+// NOTE: zero initialized ImHui is a valid context that uses realloc()/free().
+// All of the frame buffers grow on demand and are released by imhui_free().
+struct ImHui {
     size_t width, height;
 
+    ImHui_Allocator allocator;
+
+    // Reuse the tessellation of the unchanged widgets from the previous frame.
+    bool vertex_cache;
+
+    // Emit one Quad per rectangle into `quads` instead of the vertices and the triangles.
+    bool instanced;
+
+    // Debug mode: count the IDs used more than once per frame in `stats.duplicate_ids`
+    // and remember the last one of them in `duplicate_id`.
+    bool check_ids;
+    ImHui_ID duplicate_id;
+
+    size_t frame;
+    ImHui_Stats stats;
+
+    // False when imhui_end() produced exactly the same vertices, triangles, quads and
+    // batches as the previous frame, so the backends may skip uploading and presenting it.
+    // The frames with draw callbacks are always dirty.
+    bool dirty;
+
     ImHui_ID active;
+    // The topmost widget under the mouse, resolved by imhui_begin() against the
+    // widgets of the previous frame. The widgets recorded later win over the earlier ones.
+    ImHui_ID hot;
 
     Vec2 mouse_pos;
     Buttons mouse_buttons;
+    float mouse_scroll;         // accumulated until the end of the frame
+
+    // Drained by imhui_begin() when it is set
+    ImHui_Input_Queue *input;
+    double input_time;          // the time of the last event consumed from `input`
 
-    Vertex vertices[VERTICES_CAPACITY];
+    Vertex *vertices;
     size_t vertices_count;
+    size_t vertices_capacity;
 
-    Triangle triangles[TRIANGLES_CAPACITY];
+    Triangle *triangles;
     size_t triangles_count;
+    size_t triangles_capacity;
+
+    Quad *quads;
+    size_t quads_count;
+    size_t quads_capacity;
+
+    ImHui_Batch *batches;
+    size_t batches_count;
+    size_t batches_capacity;
+
+    // The output of the previous frame.
+    Vertex *prev_vertices;
+    size_t prev_vertices_count;
+    size_t prev_vertices_capacity;
+
+    Triangle *prev_triangles;
+    size_t prev_triangles_count;
+    size_t prev_triangles_capacity;
+
+    Quad *prev_quads;
+    size_t prev_quads_count;
+    size_t prev_quads_capacity;
+
+    ImHui_Batch *prev_batches;
+    size_t prev_batches_count;
+    size_t prev_batches_capacity;
+
+    ImHui_Hit_Rect *hit_rects;
+    size_t hit_rects_count;
+    size_t hit_rects_capacity;
+
+    // The rects of the previous frame, which the hot widget is resolved against
+    ImHui_Hit_Rect *prev_hit_rects;
+    size_t prev_hit_rects_count;
+    size_t prev_hit_rects_capacity;
+    bool active_hidden;         // the active widget did not record any rect on the previous frame
+
+    ImHui_Table button_cache;
+    ImHui_Table text_cache;
+    ImHui_Table id_table;
+
+    // Pooled slab of the retained widget states. The pages are never released
+    // before imhui_free(), the collected blocks go to the intrusive free list.
+    ImHui_Table state_table;
+    char **state_pages;
+    size_t state_pages_count;
+    size_t state_pages_capacity;
+    void *state_free;
+    size_t state_cursor;        // the next slot of `state_table` to collect
 
-    ImHui_Layout layout_stack[LAYOUT_STACK_CAPACITY];
+    ImHui_ID *id_stack;
+    size_t id_stack_size;
+    size_t id_stack_capacity;
+
+    ImHui_Layout_Tree layout;
+    ImHui_Layout_Tree prev_layout;
+    size_t *layout_stack;       // the nodes of `layout` that are not ended yet
     size_t layout_stack_size;
-} ImHui;
+    size_t layout_stack_capacity;
+
+    ImHui_Subtree *subtree_stack;
+    size_t subtree_stack_size;
+    size_t subtree_stack_capacity;
+    ImHui_Table subtree_cache;
+
+    ImHui_Flex_Container *flex_stack;
+    size_t flex_stack_size;
+    size_t flex_stack_capacity;
+    ImHui_Flex_Record *flex_items;
+    size_t flex_items_count;
+    size_t flex_items_capacity;
+    ImHui_Table flex_cache;
+    size_t flex_moved_frame;    // the last frame that moved already emitted items
+
+    // The bottom of the stack is the whole display, or the whole plane when
+    // either `width` or `height` is 0.
+    ImHui_Clip *clip_stack;
+    size_t clip_stack_size;
+    size_t clip_stack_capacity;
+
+    // The texture of the geometry being emitted
+    ImHui_Texture texture;
+
+    ImHui_Atlas atlas;
+
+    // Draws the text with the SDF font instead of FONT, owned by the caller.
+    // Can not be used together with the atlas.
+    const ImHui_Sdf_Font *sdf;
+    const ImHui_Sdf_Font *sdf_prev;     // the font of the previous frame
+};
+
+void imhui_free(ImHui *imhui);
 
 void imhui_mouse_down(ImHui *imhui);
 void imhui_mouse_up(ImHui *imhui);
 void imhui_mouse_move(ImHui *imhui, float x, float y);
+void imhui_mouse_scroll(ImHui *imhui, float dy);
+
+// Returns false when the queue is full and the event was dropped. The moves are merged,
+// so only a backlog of IMHUI_INPUT_QUEUE_CAPACITY clicks and scrolls can fill it up.
+bool imhui_input_push(ImHui_Input_Queue *queue, ImHui_Input_Event event);
+bool imhui_input_pending(ImHui_Input_Queue *queue);
 
 void imhui_begin(ImHui *imhui, Vec2 position, float padding);
 void imhui_text(ImHui *imhui, const char *text);
+// `id` of 0 derives the ID from the text with imhui_id()
 bool imhui_button(ImHui *imhui, const char *text, ImHui_ID id);
+void imhui_image(ImHui *imhui, ImHui_Texture texture, Vec2 size, Vec2 uv_p, Vec2 uv_s);
+void imhui_draw_callback(ImHui *imhui, ImHui_Draw_Callback callback, void *user);
 void imhui_end(ImHui *imhui);
 
+// Concatenates the output of the finished frames of `contexts` into `dst`, so a backend can
+// submit all of them at once. The contexts share nothing, so they can be built on separate
+// threads at the same time. The merge runs after all of them reached imhui_end().
+// `dst` only holds the merged output, it must not be used to build frames. `dst->dirty`
+// tells whether the merged output differs from the one of the previous merge.
+void imhui_merge(ImHui *dst, ImHui *const *contexts, size_t count);
+
 bool imhui_font_char_position(int c, size_t *x, size_t *y);
 
+// ImHui_Glyph_Rasterizer of the built-in FONT, scaled with the nearest sampling
+void imhui_font_rasterize(void *user, uint32_t codepoint, size_t width, size_t height, uint8_t *pixels, size_t stride);
+
+// Parses the `size` bytes of a .sdf file, which must outlive the font.
+// Returns false if the data is not a valid SDF font.
+bool imhui_sdf_load(ImHui *imhui, ImHui_Sdf_Font *font, const void *data, size_t size);
+void imhui_sdf_free(ImHui *imhui, ImHui_Sdf_Font *font);
+
 void imhui_render_char(ImHui *imhui, Vec2 p, float s, RGBA color, int c);
 void imhui_render_text(ImHui *imhui, Vec2 p, float s, RGBA color, const char *text);
+void imhui_render_text_len(ImHui *imhui, Vec2 p, float s, RGBA color, const char *text, size_t n);
+
+ImHui_Text_Metrics imhui_measure_text(ImHui *imhui, const char *text, float s);
+ImHui_Text_Metrics imhui_measure_text_len(ImHui *imhui, const char *text, size_t n, float s);
+
+void imhui_line_index_update(ImHui *imhui, ImHui_Line_Index *index, const char *data, size_t size);
+void imhui_line_index_reset(ImHui_Line_Index *index);
+void imhui_line_index_free(ImHui *imhui, ImHui_Line_Index *index);
+void imhui_text_view(ImHui *imhui, const ImHui_Line_Index *index, Vec2 size, float *scroll);
 
 void imhui_layout_begin(ImHui *imhui, ImHui_Layout_Type type, float padding);
 void imhui_layout_end(ImHui *imhui);
 
+// Flexbox-like layout. Every item is announced by imhui_flex_item() followed by a single
+// widget or layout, which is measured as it is emitted. imhui_flex_end() then resolves the
+// growing, the shrinking and the alignment of all of the items and remembers the slots by
+// `id`, so the next frame emits every item at its final place in a single pass. Only when
+// the slots change are the items already emitted moved, and the slot sizes returned by
+// imhui_flex_item() catch up on the next frame. `id` must be unique within the frame.
+void imhui_flex_begin(ImHui *imhui, ImHui_ID id, ImHui_Flex flex);
+// Returns the size of the slot of the item, e.g. for imhui_image() or imhui_text_view().
+// The items sized by it should set `basis`, otherwise they measure their own slot.
+Vec2 imhui_flex_item(ImHui *imhui, ImHui_Flex_Item item);
+void imhui_flex_end(ImHui *imhui);
+
+// A layout whose content is only rebuilt when it changes. Returns false if the subtree is
+// clean, i.e. `version`, its position and its clip rect are the same as on the previous
+// frame and none of its widgets is hot or active. Its layouts, geometry and hit rects are
+// then copied over from the previous frame and the caller must skip the content:
+//
+//     if (imhui_subtree_begin(&imhui, id, IMHUI_HORZ_LAYOUT, 10.0f, row->version)) {
+//         ...
+//     }
+//     imhui_subtree_end(&imhui);
+//
+// `version` has to change whenever anything the content depends on does, including the
+// versions of the nested subtrees. Those are still reused when only their parent is rebuilt.
+// Every subtree is rebuilt once in a while, so the retained states within it are not collected.
+bool imhui_subtree_begin(ImHui *imhui, ImHui_ID id, ImHui_Layout_Type type, float padding, uint64_t version);
+void imhui_subtree_end(ImHui *imhui);
+
+// The IDs within the current scope. The scopes nest, so the same labels and
+// indices produce different IDs under different parents.
+ImHui_ID imhui_id(ImHui *imhui, const char *label);
+ImHui_ID imhui_id_index(ImHui *imhui, size_t index);
+void imhui_push_id(ImHui *imhui, const char *label);
+void imhui_push_id_index(ImHui *imhui, size_t index);
+void imhui_pop_id(ImHui *imhui);
+
+// Zero initialized IMHUI_STATE_SIZE bytes owned by the widget `id`, e.g. a scroll offset or
+// an animation timer. The address stays the same until the state is collected, which happens
+// after IMHUI_STATE_MAX_AGE frames without a call of imhui_state() for the `id`.
+void *imhui_state(ImHui *imhui, ImHui_ID id, size_t size);
+
+// Everything between these is clipped to the rect intersected with the current clip rect.
+// The widgets that end up completely outside of it are not tessellated at all.
+void imhui_clip_begin(ImHui *imhui, Vec2 p, Vec2 s);
+void imhui_clip_end(ImHui *imhui);
+
+// Records the rect of the widget `id` for the hover resolution of the next frame and
+// tells whether it is the hot one, i.e. the topmost widget under the mouse.
+bool imhui_hovered(ImHui *imhui, ImHui_ID id, Vec2 p, Vec2 s);
+
+// `row_height` of 0 measures the first row, which is then always emitted
+void imhui_clipper_begin(ImHui *imhui, ImHui_Clipper *clipper, size_t rows_count, float row_height);
+bool imhui_clipper_step(ImHui *imhui, ImHui_Clipper *clipper);
+
+// A vertical layout of a fixed size that clips its content and shows it
+// starting `scroll` pixels from the top.
+void imhui_panel_begin(ImHui *imhui, Vec2 size, float scroll, float padding);
+void imhui_panel_end(ImHui *imhui);
+
 #endif // IMHUI_H_
 
 #ifdef IMHUI_IMPLEMENTATION
 
-static Vec2 imhui_font_uv(size_t pix_x, size_t pix_y)
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define IMHUI_SSE2
+#endif
+
+#define IMHUI_GLYPHS_COUNT 96
+#define IMHUI_CODEPOINT_MAX 0x10FFFF
+#define IMHUI_CODEPOINT_REPLACEMENT 0xFFFD
+
+// The UVs of the glyphs, both as floats and as the packed unorm16 of Vertex and Quad.
+// The ones of FONT are computed at compile time, the ones of the atlas on the first use.
+struct ImHui_Glyph_UV {
+    float u, v, du, dv;
+    uint16_t u0, v0, u1, v1;
+};
+
+#define IMHUI_GLYPH_DU ((float) FONT_CHAR_WIDTH / (float) FONT_WIDTH)
+#define IMHUI_GLYPH_DV ((float) FONT_CHAR_HEIGHT / (float) FONT_HEIGHT)
+#define IMHUI_GLYPH_U(i) ((float) ((i) % FONT_COLS * FONT_CHAR_WIDTH) / (float) FONT_WIDTH)
+#define IMHUI_GLYPH_V(i) ((float) ((i) / FONT_COLS * FONT_CHAR_HEIGHT) / (float) FONT_HEIGHT)
+#define IMHUI_UNORM16(x) ((uint16_t) (int32_t) ((x) * 65535.0f + 0.5f))
+#define IMHUI_GLYPH_UV(i) {                                 \
+        IMHUI_GLYPH_U(i),                                   \
+        IMHUI_GLYPH_V(i),                                   \
+        IMHUI_GLYPH_DU,                                     \
+        IMHUI_GLYPH_DV,                                     \
+        IMHUI_UNORM16(IMHUI_GLYPH_U(i)),                    \
+        IMHUI_UNORM16(IMHUI_GLYPH_V(i)),                    \
+        IMHUI_UNORM16(IMHUI_GLYPH_U(i) + IMHUI_GLYPH_DU),   \
+        IMHUI_UNORM16(IMHUI_GLYPH_V(i) + IMHUI_GLYPH_DV),   \
+    }
+#define IMHUI_GLYPH_UV8(i)                                                      \
+    IMHUI_GLYPH_UV((i) + 0), IMHUI_GLYPH_UV((i) + 1), IMHUI_GLYPH_UV((i) + 2),  \
+    IMHUI_GLYPH_UV((i) + 3), IMHUI_GLYPH_UV((i) + 4), IMHUI_GLYPH_UV((i) + 5),  \
+    IMHUI_GLYPH_UV((i) + 6), IMHUI_GLYPH_UV((i) + 7)
+
+static const ImHui_Glyph_UV imhui_glyph_uvs[IMHUI_GLYPHS_COUNT] = {
+    IMHUI_GLYPH_UV8(0),  IMHUI_GLYPH_UV8(8),  IMHUI_GLYPH_UV8(16), IMHUI_GLYPH_UV8(24),
+    IMHUI_GLYPH_UV8(32), IMHUI_GLYPH_UV8(40), IMHUI_GLYPH_UV8(48), IMHUI_GLYPH_UV8(56),
+    IMHUI_GLYPH_UV8(64), IMHUI_GLYPH_UV8(72), IMHUI_GLYPH_UV8(80), IMHUI_GLYPH_UV8(88),
+};
+
+// Anything outside of [32, 127] is rendered as FONT_SOLID_CHAR
+static const ImHui_Glyph_UV *imhui_glyph_uv(int c)
 {
-    const float uv_x = (float) pix_x / (float) FONT_WIDTH;
-    const float uv_y = (float) pix_y / (float) FONT_HEIGHT;
-    return vec2(uv_x, uv_y);
+    const unsigned int index = (unsigned int) c - 32;
+    return &imhui_glyph_uvs[index < IMHUI_GLYPHS_COUNT ? index : FONT_SOLID_CHAR - 32];
 }
 
-static void imhui_char_uv(int c, Vec2 *uv_p, Vec2 *uv_s)
+static void *imhui_realloc(ImHui *imhui, void *ptr, size_t old_size, size_t new_size)
 {
-    if (32 <= c && c <= 127) {
-        const size_t index  = c - 32;
-        const size_t cell_x = index % FONT_COLS;
-        const size_t cell_y = index / FONT_COLS;
-        const size_t pix_x  = cell_x * FONT_CHAR_WIDTH;
-        const size_t pix_y  = cell_y * FONT_CHAR_HEIGHT;
-        *uv_p = imhui_font_uv(pix_x, pix_y);
-        *uv_s = imhui_font_uv(FONT_CHAR_WIDTH, FONT_CHAR_HEIGHT);
-        // uv_p->y += uv_s->y;
-        // uv_s->y = -uv_s->y;
-    } else {
-        imhui_char_uv(127, uv_p, uv_s);
+    if (imhui->allocator.alloc) {
+        return imhui->allocator.alloc(imhui->allocator.user, ptr, old_size, new_size);
     }
+
+    if (new_size == 0) {
+        free(ptr);
+        return NULL;
+    }
+
+    return realloc(ptr, new_size);
 }
 
-static void imhui_layout_start(ImHui *imhui, ImHui_Layout_Type type, Vec2 start, float padding)
+// Makes sure that `items` can hold at least `required` elements of `item_size`.
+// Returns the (possibly moved) items and updates `capacity`.
+static void *imhui_reserve(ImHui *imhui, void *items, size_t item_size, size_t *capacity, size_t required)
 {
-    assert(imhui->layout_stack_size < LAYOUT_STACK_CAPACITY);
-    imhui->layout_stack[imhui->layout_stack_size].type = type;
-    imhui->layout_stack[imhui->layout_stack_size].padding = padding;
-    imhui->layout_stack[imhui->layout_stack_size].size = vec2(0.0f, 0.0f);
-    imhui->layout_stack[imhui->layout_stack_size].start = start;
-    imhui->layout_stack_size += 1;
+    if (required <= *capacity) {
+        return items;
+    }
+
+    size_t new_capacity = *capacity == 0 ? IMHUI_INITIAL_CAPACITY : *capacity;
+    while (new_capacity < required) {
+        new_capacity *= 2;
+    }
+
+    items = imhui_realloc(imhui, items, *capacity * item_size, new_capacity * item_size);
+    assert(items != NULL && "imhui_reserve: out of memory");
+    *capacity = new_capacity;
+    return items;
 }
 
-static ImHui_Layout *imhui_top_layout(ImHui *imhui)
+static uint64_t imhui_hash_u64(uint64_t x)
 {
-    assert(imhui->layout_stack_size > 0);
-    return &imhui->layout_stack[imhui->layout_stack_size - 1];
+    // NOTE: the finalizer of splitmix64
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
 }
 
-static Vec2 imhui_next_widget_position(ImHui *imhui)
-{
-    ImHui_Layout *layout = imhui_top_layout(imhui);
+#define IMHUI_FNV_OFFSET 0xcbf29ce484222325ULL
+#define IMHUI_FNV_PRIME 0x100000001b3ULL
 
-    switch (layout->type) {
-    case IMHUI_VERT_LAYOUT:
-        return vec2(layout->start.x, layout->start.y + layout->size.y);
-    case IMHUI_HORZ_LAYOUT:
-        return vec2(layout->start.x + layout->size.x, layout->start.y);
-    default:
-        assert(false && "imhui_next_widget_position: unreachable");
-        exit(1);
+// FNV-1a of a NULL-terminated string. Also reports the length of the string,
+// so the callers do not have to scan it twice.
+static uint64_t imhui_hash_cstr(const char *text, size_t *n)
+{
+    uint64_t hash = IMHUI_FNV_OFFSET;
+    size_t i = 0;
+    for (; text[i] != '\0'; ++i) {
+        hash ^= (unsigned char) text[i];
+        hash *= IMHUI_FNV_PRIME;
     }
+    *n = i;
+    return hash;
 }
 
-static void imhui_expand_layout(ImHui *imhui, Vec2 widget_size)
+static uint64_t imhui_hash_bytes(const char *text, size_t n)
 {
-    ImHui_Layout *layout = imhui_top_layout(imhui);
-
-    switch (layout->type) {
-    case IMHUI_VERT_LAYOUT:
-        layout->size.y += widget_size.y + layout->padding;
-        if (layout->size.x < widget_size.x) {
-            layout->size.x = widget_size.x;
-        }
-        break;
-    case IMHUI_HORZ_LAYOUT:
-        layout->size.x += widget_size.x + layout->padding;
-        if (layout->size.y < widget_size.y) {
-            layout->size.y = widget_size.y;
-        }
-        break;
-    default:
-        assert(false && "imhui_expand_layout: unreachable");
-        exit(1);
+    uint64_t hash = IMHUI_FNV_OFFSET;
+    for (size_t i = 0; i < n; ++i) {
+        hash ^= (unsigned char) text[i];
+        hash *= IMHUI_FNV_PRIME;
     }
+    return hash;
 }
 
-void imhui_layout_begin(ImHui *imhui, ImHui_Layout_Type type, float padding)
+// The root scope of the IDs
+#define IMHUI_ID_SEED 0x9e3779b97f4a7c15ULL
+
+static ImHui_ID imhui_id_combine(ImHui_ID scope, uint64_t hash)
 {
-    const Vec2 start = imhui_next_widget_position(imhui);
-    imhui_layout_start(imhui, type, start, padding);
+    const ImHui_ID id = imhui_hash_u64(scope * IMHUI_FNV_PRIME ^ hash);
+    return id == 0 ? 1 : id;
 }
 
-void imhui_layout_end(ImHui *imhui)
+static ImHui_ID imhui_top_id(const ImHui *imhui)
 {
-    Vec2 child_layout_size = imhui_top_layout(imhui)->size;
-    --imhui->layout_stack_size;
+    return imhui->id_stack_size > 0 ? imhui->id_stack[imhui->id_stack_size - 1] : IMHUI_ID_SEED;
+}
 
-    if (imhui->layout_stack_size > 0) {
-        imhui_expand_layout(imhui, child_layout_size);
-    }
+ImHui_ID imhui_id(ImHui *imhui, const char *label)
+{
+    size_t n = 0;
+    return imhui_id_combine(imhui_top_id(imhui), imhui_hash_cstr(label, &n));
 }
 
-static unsigned int imhui_append_vertex(ImHui *imhui, Vertex v)
+ImHui_ID imhui_id_index(ImHui *imhui, size_t index)
 {
-    assert(imhui->vertices_count < VERTICES_CAPACITY);
-    unsigned int result = imhui->vertices_count;
-    imhui->vertices[imhui->vertices_count++] = v;
-    return result;
+    return imhui_id_combine(imhui_top_id(imhui), index);
 }
 
-static void imhui_append_triangle(ImHui *imhui, Triangle t)
+static void imhui_push_id_value(ImHui *imhui, ImHui_ID id)
 {
-    assert(imhui->triangles_count < TRIANGLES_CAPACITY);
-    imhui->triangles[imhui->triangles_count++] = t;
+    imhui->id_stack = imhui_reserve(
+                          imhui,
+                          imhui->id_stack,
+                          sizeof(*imhui->id_stack),
+                          &imhui->id_stack_capacity,
+                          imhui->id_stack_size + 1);
+    imhui->id_stack[imhui->id_stack_size++] = id;
 }
 
-static void imhui_fill_rect_char(ImHui *imhui, Vec2 p, Vec2 s, RGBA c, int ch)
+void imhui_push_id(ImHui *imhui, const char *label)
 {
-    Vec2 uv_p, uv_s;
-    imhui_char_uv(ch, &uv_p, &uv_s);
-
-    const unsigned int p0 = imhui_append_vertex(
-                                imhui,
-                                vertex(p, c, uv_p));
-    const unsigned int p1 = imhui_append_vertex(
-                                imhui,
-                                vertex(vec2(p.x + s.x, p.y),
-                                       c,
-                                       vec2(uv_p.x + uv_s.x, uv_p.y)));
-    const unsigned int p2 = imhui_append_vertex(
-                                imhui,
-                                vertex(vec2(p.x, p.y + s.y),
-                                       c,
-                                       vec2(uv_p.x, uv_p.y + uv_s.y)));
-    const unsigned int p3 = imhui_append_vertex(
-                                imhui,
-                                vertex(vec2(p.x + s.x, p.y + s.y),
-                                       c,
-                                       vec2(uv_p.x + uv_s.x, uv_p.y + uv_s.y)));
+    imhui_push_id_value(imhui, imhui_id(imhui, label));
+}
 
-    imhui_append_triangle(imhui, triangle(p0, p1, p2));
-    imhui_append_triangle(imhui, triangle(p1, p2, p3));
+void imhui_push_id_index(ImHui *imhui, size_t index)
+{
+    imhui_push_id_value(imhui, imhui_id_index(imhui, index));
 }
 
-static void imhui_fill_rect(ImHui *imhui, Vec2 p, Vec2 s, RGBA c)
+void imhui_pop_id(ImHui *imhui)
 {
-    imhui_fill_rect_char(imhui, p, s, c, FONT_SOLID_CHAR);
+    assert(imhui->id_stack_size > 0 && "imhui_pop_id: no matching imhui_push_id");
+    imhui->id_stack_size -= 1;
 }
 
-static bool imhui_rect_contains(Vec2 p, Vec2 s, Vec2 t)
+static ImHui_Slot *imhui_table_slot(const ImHui_Table *table, size_t index)
 {
-    return p.x <= t.x && t.x < p.x + s.x &&
-           p.y <= t.y && t.y < p.y + s.y;
+    return (ImHui_Slot*) (table->slots + index * table->slot_size);
 }
 
-void imhui_render_char(ImHui *imhui, Vec2 p, float s, RGBA color, int ch)
+static size_t imhui_table_home(const ImHui_Table *table, uint64_t key)
 {
-    imhui_fill_rect_char(imhui, p, vec2((float) FONT_CHAR_WIDTH * s, (float) FONT_CHAR_HEIGHT * s), color, ch);
+    return imhui_hash_u64(key) & (table->capacity - 1);
 }
 
-// TODO(#6): consider rendering the text with bitmap textures instead of triangle
-// It's too many god damn triangles
-void imhui_render_text(ImHui *imhui, Vec2 p, float s, RGBA color, const char *text)
+static void imhui_table_grow(ImHui *imhui, ImHui_Table *table, size_t slot_size)
 {
-    const size_t n = strlen(text);
-    for (size_t i = 0; i < n; ++i) {
-        imhui_render_char(
-            imhui,
-            vec2(p.x + i * s * FONT_CHAR_WIDTH, p.y),
-            s,
-            color,
-            text[i]);
+    ImHui_Table new_table = {
+        .slot_size = slot_size,
+        .capacity = table->capacity == 0 ? IMHUI_INITIAL_CAPACITY : table->capacity * 2,
+        .count = table->count,
+    };
+    new_table.slots = imhui_realloc(imhui, NULL, 0, new_table.capacity * slot_size);
+    assert(new_table.slots != NULL && "imhui_table_grow: out of memory");
+    memset(new_table.slots, 0, new_table.capacity * slot_size);
+
+    for (size_t i = 0; i < table->capacity; ++i) {
+        ImHui_Slot *slot = imhui_table_slot(table, i);
+        if (slot->key != 0) {
+            size_t j = imhui_table_home(&new_table, slot->key);
+            while (imhui_table_slot(&new_table, j)->key != 0) {
+                j = (j + 1) & (new_table.capacity - 1);
+            }
+            memcpy(imhui_table_slot(&new_table, j), slot, slot_size);
+        }
     }
+
+    imhui_realloc(imhui, table->slots, table->capacity * table->slot_size, 0);
+    *table = new_table;
 }
 
-void imhui_mouse_down(ImHui *imhui)
+// Finds the slot of the key or inserts a zeroed one. Check `slot.frame == 0`
+// to distinguish the freshly inserted slots.
+static void *imhui_table_insert(ImHui *imhui, ImHui_Table *table, size_t slot_size, uint64_t key)
 {
-    imhui->mouse_buttons = imhui->mouse_buttons | BUTTON_LEFT;
+    assert(key != 0);
+    assert(table->capacity == 0 || table->slot_size == slot_size);
+
+    if ((table->count + 1) * 4 > table->capacity * 3) {
+        imhui_table_grow(imhui, table, slot_size);
+    }
+
+    for (size_t i = imhui_table_home(table, key);; i = (i + 1) & (table->capacity - 1)) {
+        ImHui_Slot *slot = imhui_table_slot(table, i);
+        if (slot->key == key) {
+            return slot;
+        }
+        if (slot->key == 0) {
+            memset(slot, 0, slot_size);
+            slot->key = key;
+            table->count += 1;
+            return slot;
+        }
+    }
 }
 
-void imhui_mouse_up(ImHui *imhui)
+static void imhui_table_touch(ImHui_Table *table, void *slot, size_t frame)
 {
-    imhui->mouse_buttons = imhui->mouse_buttons & (~BUTTON_LEFT);
+    ImHui_Slot *header = slot;
+    if (header->frame != frame) {
+        header->frame = frame;
+        table->touched += 1;
+    }
 }
 
-void imhui_mouse_move(ImHui *imhui, float x, float y)
+// Backward shift deletion, so the table never accumulates tombstones.
+static void imhui_table_remove_at(ImHui_Table *table, size_t i)
 {
-    imhui->mouse_pos = vec2(x, y);
+    const size_t mask = table->capacity - 1;
+    for (size_t j = (i + 1) & mask;; j = (j + 1) & mask) {
+        ImHui_Slot *slot = imhui_table_slot(table, j);
+        if (slot->key == 0) {
+            break;
+        }
+
+        // Move the slot at j into the hole at i unless its home lies cyclically in (i, j]
+        const size_t home = imhui_table_home(table, slot->key);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            memcpy(imhui_table_slot(table, i), slot, table->slot_size);
+            i = j;
+        }
+    }
+
+    imhui_table_slot(table, i)->key = 0;
+    table->count -= 1;
 }
 
-void imhui_begin(ImHui *imhui, Vec2 start, float padding)
+// Removes all of the slots that were not touched since `min_frame`. Must be
+// called once per frame with the slots touched through imhui_table_touch().
+static void imhui_table_sweep(ImHui_Table *table, size_t min_frame)
 {
-    imhui->vertices_count = 0;
-    imhui->triangles_count = 0;
-    imhui_layout_start(imhui, IMHUI_VERT_LAYOUT, start, padding);
+    const bool all_touched = table->touched == table->count;
+    table->touched = 0;
+    if (all_touched) {
+        return;
+    }
+
+    for (size_t i = 0; i < table->capacity; ++i) {
+        ImHui_Slot *slot = imhui_table_slot(table, i);
+        while (slot->key != 0 && slot->frame < min_frame) {
+            imhui_table_remove_at(table, i);
+        }
+    }
 }
 
-void imhui_text(ImHui *imhui, const char *text)
+static void imhui_table_clear(ImHui_Table *table)
 {
-    (void) imhui;
-    (void) text;
-    assert(false && "TODO(#7): imhui_text() is not implemented for some reason");
+    if (table->slots != NULL) {
+        memset(table->slots, 0, table->capacity * table->slot_size);
+    }
+    table->count = 0;
+    table->touched = 0;
 }
 
-bool imhui_button(ImHui *imhui, const char *text, ImHui_ID id)
+static void imhui_table_free(ImHui *imhui, ImHui_Table *table)
 {
-    const Vec2 p = imhui_next_widget_position(imhui);
-    const Vec2 s = IMHUI_BUTTON_SIZE;
-    imhui_expand_layout(imhui, s);
-
-    bool clicked = false;
-    RGBA color = IMHUI_BUTTON_COLOR;
-    Vec2 offset = IMHUI_BUTTON_OFFSET;
+    imhui_realloc(imhui, table->slots, table->capacity * table->slot_size, 0);
+    memset(table, 0, sizeof(*table));
+}
+
+// Counts the IDs used more than once within the frame with `check_ids`
+static void imhui_check_id(ImHui *imhui, ImHui_ID id)
+{
+    if (imhui->check_ids) {
+        ImHui_Slot *slot = imhui_table_insert(imhui, &imhui->id_table, sizeof(*slot), id);
+        if (slot->frame == imhui->frame) {
+            imhui->stats.duplicate_ids += 1;
+            imhui->duplicate_id = id;
+        }
+        imhui_table_touch(&imhui->id_table, slot, imhui->frame);
+    }
+}
+
+static void *imhui_state_alloc(ImHui *imhui)
+{
+    if (imhui->state_free == NULL) {
+        imhui->state_pages = imhui_reserve(
+                                 imhui,
+                                 imhui->state_pages,
+                                 sizeof(*imhui->state_pages),
+                                 &imhui->state_pages_capacity,
+                                 imhui->state_pages_count + 1);
+        char *page = imhui_realloc(imhui, NULL, 0, IMHUI_STATE_PAGE_BLOCKS * IMHUI_STATE_SIZE);
+        assert(page != NULL && "imhui_state_alloc: out of memory");
+        imhui->state_pages[imhui->state_pages_count++] = page;
+
+        for (size_t i = IMHUI_STATE_PAGE_BLOCKS; i > 0; --i) {
+            void *block = page + (i - 1) * IMHUI_STATE_SIZE;
+            *(void**) block = imhui->state_free;
+            imhui->state_free = block;
+        }
+    }
+
+    void *block = imhui->state_free;
+    imhui->state_free = *(void**) block;
+    return block;
+}
+
+static void imhui_state_release(ImHui *imhui, void *block)
+{
+    *(void**) block = imhui->state_free;
+    imhui->state_free = block;
+}
+
+void *imhui_state(ImHui *imhui, ImHui_ID id, size_t size)
+{
+    assert(size <= IMHUI_STATE_SIZE && "imhui_state: the state does not fit into IMHUI_STATE_SIZE");
+    (void) size;
+
+    ImHui_State_Entry *entry = imhui_table_insert(imhui, &imhui->state_table, sizeof(*entry), id);
+    if (entry->block == NULL) {
+        entry->block = imhui_state_alloc(imhui);
+        memset(entry->block, 0, IMHUI_STATE_SIZE);
+    }
+    imhui_table_touch(&imhui->state_table, entry, imhui->frame);
+    return entry->block;
+}
+
+// NOTE: unlike imhui_table_sweep() every frame visits only 1/IMHUI_STATE_MAX_AGE of the
+// table, so the cost does not grow with the number of live widgets. A state is collected
+// between IMHUI_STATE_MAX_AGE and twice as many frames after its last lookup.
+static void imhui_state_collect(ImHui *imhui)
+{
+    ImHui_Table *table = &imhui->state_table;
+    table->touched = 0;
+    if (table->count == 0 || imhui->frame <= IMHUI_STATE_MAX_AGE) {
+        return;
+    }
+
+    const size_t min_frame = imhui->frame - IMHUI_STATE_MAX_AGE;
+    const size_t n = table->capacity / IMHUI_STATE_MAX_AGE + 1;
+    for (size_t k = 0; k < n; ++k) {
+        const size_t i = imhui->state_cursor++ & (table->capacity - 1);
+        ImHui_State_Entry *entry = (ImHui_State_Entry*) imhui_table_slot(table, i);
+        while (entry->slot.key != 0 && entry->slot.frame < min_frame) {
+            imhui_state_release(imhui, entry->block);
+            imhui_table_remove_at(table, i);
+        }
+    }
+}
+
+void imhui_font_rasterize(void *user, uint32_t codepoint, size_t width, size_t height, uint8_t *pixels, size_t stride)
+{
+    (void) user;
+    const uint32_t index = codepoint - 32 < IMHUI_GLYPHS_COUNT ? codepoint - 32 : FONT_SOLID_CHAR - 32;
+    const size_t gx = index % FONT_COLS * FONT_CHAR_WIDTH;
+    const size_t gy = index / FONT_COLS * FONT_CHAR_HEIGHT;
+    for (size_t y = 0; y < height; ++y) {
+        const unsigned char *row = &FONT[(gy + (2 * y + 1) * FONT_CHAR_HEIGHT / (2 * height)) * FONT_WIDTH + gx];
+        for (size_t x = 0; x < width; ++x) {
+            pixels[y * stride + x] = row[(2 * x + 1) * FONT_CHAR_WIDTH / (2 * width)];
+        }
+    }
+}
+
+static uint32_t imhui_read_u32_le(const uint8_t *bytes)
+{
+    return (uint32_t) bytes[0] | (uint32_t) bytes[1] << 8 | (uint32_t) bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+}
+
+bool imhui_sdf_load(ImHui *imhui, ImHui_Sdf_Font *font, const void *data, size_t size)
+{
+    const uint8_t *bytes = data;
+    if (size < IMHUI_SDF_HEADER_SIZE || memcmp(bytes, IMHUI_SDF_MAGIC, 4) != 0) {
+        return false;
+    }
+
+    uint32_t fields[10];
+    for (size_t i = 0; i < 10; ++i) {
+        fields[i] = imhui_read_u32_le(bytes + 4 + 4 * i);
+    }
+    const uint32_t version = fields[0];
+    const size_t width = fields[1];
+    const size_t height = fields[2];
+    const size_t cell_width = fields[3];
+    const size_t cell_height = fields[4];
+    const size_t padding = fields[5];
+    const uint32_t spread = fields[6];
+    const uint32_t first = fields[7];
+    const uint32_t count = fields[8];
+    const size_t columns = fields[9];
+    if (version != IMHUI_SDF_VERSION || width == 0 || height == 0 ||
+            cell_width == 0 || cell_height == 0 || spread == 0 || columns == 0 ||
+            count > IMHUI_CODEPOINT_MAX || (size - IMHUI_SDF_HEADER_SIZE) / width < height) {
+        return false;
+    }
+
+    // NOTE: the cells of all of the glyphs and of the solid rect must fit into the atlas
+    const size_t stride_x = cell_width + 2 * padding;
+    const size_t stride_y = cell_height + 2 * padding;
+    const size_t rows = ((size_t) count + 1 + columns - 1) / columns;
+    if (columns > width / stride_x || rows > height / stride_y) {
+        return false;
+    }
+
+    ImHui_Glyph_UV *uvs = imhui_realloc(imhui, NULL, 0, ((size_t) count + 1) * sizeof(*uvs));
+    assert(uvs != NULL && "imhui_sdf_load: out of memory");
+    for (size_t i = 0; i <= count; ++i) {
+        const size_t x = i % columns * stride_x + padding;
+        const size_t y = i / columns * stride_y + padding;
+        ImHui_Glyph_UV *uv = &uvs[i];
+        uv->u = (float) x / (float) width;
+        uv->v = (float) y / (float) height;
+        uv->du = (float) cell_width / (float) width;
+        uv->dv = (float) cell_height / (float) height;
+        uv->u0 = imhui_pack_unorm16(uv->u);
+        uv->v0 = imhui_pack_unorm16(uv->v);
+        uv->u1 = imhui_pack_unorm16(uv->u + uv->du);
+        uv->v1 = imhui_pack_unorm16(uv->v + uv->dv);
+    }
+
+    *font = (ImHui_Sdf_Font) {
+        .width = width,
+        .height = height,
+        .pixels = bytes + IMHUI_SDF_HEADER_SIZE,
+        .cell_width = cell_width,
+        .cell_height = cell_height,
+        .padding = padding,
+        .spread = (float) spread,
+        .first = first,
+        .count = count,
+        .columns = columns,
+        .uvs = uvs,
+    };
+    return true;
+}
+
+void imhui_sdf_free(ImHui *imhui, ImHui_Sdf_Font *font)
+{
+    if (font->uvs != NULL) {
+        imhui_realloc(imhui, font->uvs, ((size_t) font->count + 1) * sizeof(*font->uvs), 0);
+    }
+    memset(font, 0, sizeof(*font));
+}
+
+// The length of the ASCII prefix of `text`. Text is mostly ASCII, so this is
+// what all of the UTF-8 handling spends its time on.
+static size_t imhui_utf8_ascii(const char *text, size_t n)
+{
+    size_t i = 0;
+#ifdef IMHUI_SSE2
+    for (; i + 16 <= n; i += 16) {
+        if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *) (text + i))) != 0) {
+            break;
+        }
+    }
+#endif // IMHUI_SSE2
+    for (; i + 8 <= n; i += 8) {
+        uint64_t word;
+        memcpy(&word, text + i, sizeof(word));
+        if ((word & 0x8080808080808080ull) != 0) {
+            break;
+        }
+    }
+    while (i < n && (unsigned char) text[i] < 0x80) {
+        i += 1;
+    }
+    return i;
+}
+
+// Decodes the codepoint at the start of the `n` > 0 bytes of `text` and sets `*len` to
+// its length. Every byte of an invalid sequence (overlong, surrogate, beyond U+10FFFF,
+// truncated or a stray continuation byte) decodes into a separate U+FFFD.
+static uint32_t imhui_utf8_decode(const char *text, size_t n, size_t *len)
+{
+    const unsigned char *bytes = (const unsigned char *) text;
+    *len = 1;
+    if (bytes[0] < 0x80) {
+        return bytes[0];
+    }
+
+    size_t count;
+    uint32_t c, min;
+    if ((bytes[0] & 0xE0) == 0xC0) {
+        count = 2;
+        c = bytes[0] & 0x1F;
+        min = 0x80;
+    } else if ((bytes[0] & 0xF0) == 0xE0) {
+        count = 3;
+        c = bytes[0] & 0x0F;
+        min = 0x800;
+    } else if ((bytes[0] & 0xF8) == 0xF0) {
+        count = 4;
+        c = bytes[0] & 0x07;
+        min = 0x10000;
+    } else {
+        return IMHUI_CODEPOINT_REPLACEMENT;
+    }
+
+    if (count > n) {
+        return IMHUI_CODEPOINT_REPLACEMENT;
+    }
+    for (size_t i = 1; i < count; ++i) {
+        if ((bytes[i] & 0xC0) != 0x80) {
+            return IMHUI_CODEPOINT_REPLACEMENT;
+        }
+        c = (c << 6) | (bytes[i] & 0x3F);
+    }
+    if (c < min || c > IMHUI_CODEPOINT_MAX || (c >= 0xD800 && c <= 0xDFFF)) {
+        return IMHUI_CODEPOINT_REPLACEMENT;
+    }
+
+    *len = count;
+    return c;
+}
+
+// Skips at most `*count` codepoints of `text`. Returns the bytes skipped and sets
+// `*count` to the codepoints skipped.
+static size_t imhui_utf8_skip(const char *text, size_t n, size_t *count)
+{
+    size_t i = 0;
+    size_t skipped = 0;
+    while (i < n && skipped < *count) {
+        const size_t limit = n - i < *count - skipped ? n - i : *count - skipped;
+        const size_t ascii = imhui_utf8_ascii(text + i, limit);
+        i += ascii;
+        skipped += ascii;
+        if (ascii < limit) {
+            size_t len;
+            imhui_utf8_decode(text + i, n - i, &len);
+            i += len;
+            skipped += 1;
+        }
+    }
+    *count = skipped;
+    return i;
+}
+
+static size_t imhui_utf8_length(const char *text, size_t n)
+{
+    size_t count = SIZE_MAX;
+    imhui_utf8_skip(text, n, &count);
+    return count;
+}
+
+// NOTE: the atlas starts with a solid and a blank IMHUI_ATLAS_BLOCK x IMHUI_ATLAS_BLOCK
+// block at (0, 0). The rects and the glyphs that did not fit sample the middle of them.
+#define IMHUI_ATLAS_BLOCK 4
+#define IMHUI_ATLAS_PADDING 1
+
+#define IMHUI_GLYPH_PAGE_SIZE 256
+#define IMHUI_GLYPH_PAGES ((IMHUI_CODEPOINT_MAX + 1) / IMHUI_GLYPH_PAGE_SIZE)
+
+struct ImHui_Glyph_Page {
+    uint32_t present[IMHUI_GLYPH_PAGE_SIZE / 32];
+    ImHui_Glyph_UV uvs[IMHUI_GLYPH_PAGE_SIZE];
+};
+
+static void imhui_atlas_uv(ImHui_Glyph_UV *uv, size_t x, size_t y, size_t w, size_t h)
+{
+    uv->u = (float) x / (float) IMHUI_ATLAS_WIDTH;
+    uv->v = (float) y / (float) IMHUI_ATLAS_HEIGHT;
+    uv->du = (float) w / (float) IMHUI_ATLAS_WIDTH;
+    uv->dv = (float) h / (float) IMHUI_ATLAS_HEIGHT;
+    uv->u0 = imhui_pack_unorm16(uv->u);
+    uv->v0 = imhui_pack_unorm16(uv->v);
+    uv->u1 = imhui_pack_unorm16(uv->u + uv->du);
+    uv->v1 = imhui_pack_unorm16(uv->v + uv->dv);
+}
+
+static void imhui_atlas_mark_dirty(ImHui_Atlas *atlas, size_t x, size_t y, size_t w, size_t h)
+{
+    if (atlas->dirty_x0 == atlas->dirty_x1) {
+        atlas->dirty_x0 = x;
+        atlas->dirty_y0 = y;
+        atlas->dirty_x1 = x + w;
+        atlas->dirty_y1 = y + h;
+        return;
+    }
+    atlas->dirty_x0 = x < atlas->dirty_x0 ? x : atlas->dirty_x0;
+    atlas->dirty_y0 = y < atlas->dirty_y0 ? y : atlas->dirty_y0;
+    atlas->dirty_x1 = x + w > atlas->dirty_x1 ? x + w : atlas->dirty_x1;
+    atlas->dirty_y1 = y + h > atlas->dirty_y1 ? y + h : atlas->dirty_y1;
+}
+
+// Shelf packing: the rect goes onto the shortest shelf that fits it without wasting more
+// than a quarter of the height, or onto a new shelf at the bottom.
+static bool imhui_atlas_pack(ImHui *imhui, size_t w, size_t h, size_t *x, size_t *y)
+{
+    ImHui_Atlas *atlas = &imhui->atlas;
+    ImHui_Atlas_Shelf *best = NULL;
+    for (size_t i = 0; i < atlas->shelves_count; ++i) {
+        ImHui_Atlas_Shelf *shelf = &atlas->shelves[i];
+        if (shelf->height >= h && shelf->height <= h + h / 4 && shelf->x + w <= IMHUI_ATLAS_WIDTH &&
+                (best == NULL || shelf->height < best->height)) {
+            best = shelf;
+        }
+    }
+
+    if (best == NULL) {
+        const ImHui_Atlas_Shelf *last = atlas->shelves_count > 0 ? &atlas->shelves[atlas->shelves_count - 1] : NULL;
+        const size_t top = last != NULL ? last->y + last->height : 0;
+        if (w > IMHUI_ATLAS_WIDTH || top + h > IMHUI_ATLAS_HEIGHT) {
+            return false;
+        }
+
+        atlas->shelves = imhui_reserve(
+                             imhui,
+                             atlas->shelves,
+                             sizeof(*atlas->shelves),
+                             &atlas->shelves_capacity,
+                             atlas->shelves_count + 1);
+        best = &atlas->shelves[atlas->shelves_count++];
+        *best = (ImHui_Atlas_Shelf) {
+            .y = top,
+            .height = h,
+        };
+    }
+
+    *x = best->x;
+    *y = best->y;
+    best->x += w;
+    return true;
+}
+
+// NOTE: the sizes that are no longer used are dropped together with their pages
+static void imhui_atlas_free_sizes(ImHui *imhui)
+{
+    ImHui_Atlas *atlas = &imhui->atlas;
+    for (size_t i = 0; i < atlas->sizes_count; ++i) {
+        ImHui_Glyph_Page **pages = atlas->sizes[i].pages;
+        for (size_t j = 0; j < IMHUI_GLYPH_PAGES; ++j) {
+            if (pages[j] != NULL) {
+                imhui_realloc(imhui, pages[j], sizeof(*pages[j]), 0);
+            }
+        }
+        imhui_realloc(imhui, pages, IMHUI_GLYPH_PAGES * sizeof(*pages), 0);
+    }
+    atlas->sizes_count = 0;
+}
+
+// Starts over with nothing but the solid and the blank blocks
+static void imhui_atlas_reset(ImHui *imhui)
+{
+    ImHui_Atlas *atlas = &imhui->atlas;
+    if (atlas->pixels == NULL) {
+        atlas->pixels = imhui_realloc(imhui, NULL, 0, IMHUI_ATLAS_WIDTH * IMHUI_ATLAS_HEIGHT);
+        assert(atlas->pixels != NULL && "imhui_atlas_reset: out of memory");
+    }
+    memset(atlas->pixels, 0, IMHUI_ATLAS_WIDTH * IMHUI_ATLAS_HEIGHT);
+    imhui_atlas_free_sizes(imhui);
+    atlas->shelves_count = 0;
+    atlas->full = false;
+
+    size_t x, y;
+    const bool packed = imhui_atlas_pack(imhui, 2 * IMHUI_ATLAS_BLOCK + IMHUI_ATLAS_PADDING,
+                                         IMHUI_ATLAS_BLOCK + IMHUI_ATLAS_PADDING, &x, &y);
+    assert(packed && x == 0 && y == 0);
+    for (size_t i = 0; i < IMHUI_ATLAS_BLOCK; ++i) {
+        memset(&atlas->pixels[i * IMHUI_ATLAS_WIDTH], 0xFF, IMHUI_ATLAS_BLOCK);
+    }
+    imhui_atlas_mark_dirty(atlas, 0, 0, IMHUI_ATLAS_WIDTH, IMHUI_ATLAS_HEIGHT);
+}
+
+// Called by imhui_begin(). The atlas is switched on and off by setting `atlas.rasterize`.
+static void imhui_atlas_begin(ImHui *imhui)
+{
+    ImHui_Atlas *atlas = &imhui->atlas;
+    atlas->dirty_x0 = 0;
+    atlas->dirty_y0 = 0;
+    atlas->dirty_x1 = 0;
+    atlas->dirty_y1 = 0;
+
+    const bool active = atlas->rasterize != NULL;
+    assert((!active || imhui->sdf == NULL) && "imhui_begin: the atlas can not be used with the SDF font");
+    if (imhui->sdf != imhui->sdf_prev) {
+        imhui_table_clear(&imhui->button_cache);
+        imhui_table_clear(&imhui->subtree_cache);
+        imhui->sdf_prev = imhui->sdf;
+    }
+    if (active != atlas->active || (active && atlas->full)) {
+        if (active) {
+            imhui_atlas_reset(imhui);
+        }
+        // NOTE: the tessellation cached by the buttons and the subtrees refers to the old UVs
+        imhui_table_clear(&imhui->button_cache);
+        imhui_table_clear(&imhui->subtree_cache);
+    }
+    atlas->active = active;
+}
+
+static size_t imhui_atlas_cell(float x)
+{
+    const size_t n = (size_t) (x + 0.5f);
+    return n > 0 ? n : 1;
+}
+
+// The index of the glyphs rasterized into `w` x `h` cells. A frame only has a few sizes
+// of text and every run of text looks its size up once.
+static size_t imhui_atlas_size(ImHui *imhui, size_t w, size_t h)
+{
+    ImHui_Atlas *atlas = &imhui->atlas;
+    for (size_t i = 0; i < atlas->sizes_count; ++i) {
+        if (atlas->sizes[i].width == w && atlas->sizes[i].height == h) {
+            return i;
+        }
+    }
+
+    atlas->sizes = imhui_reserve(
+                       imhui,
+                       atlas->sizes,
+                       sizeof(*atlas->sizes),
+                       &atlas->sizes_capacity,
+                       atlas->sizes_count + 1);
+    ImHui_Glyph_Page **pages = imhui_realloc(imhui, NULL, 0, IMHUI_GLYPH_PAGES * sizeof(*pages));
+    assert(pages != NULL && "imhui_atlas_size: out of memory");
+    memset(pages, 0, IMHUI_GLYPH_PAGES * sizeof(*pages));
+    atlas->sizes[atlas->sizes_count] = (ImHui_Atlas_Size) {
+        .width = w,
+        .height = h,
+        .pages = pages,
+    };
+    return atlas->sizes_count++;
+}
+
+// The glyph of the `size`. Only the first lookup of a glyph at a size rasterizes
+// it, the rest of them are two loads and a bit test.
+static const ImHui_Glyph_UV *imhui_atlas_glyph(ImHui *imhui, size_t size, uint32_t codepoint)
+{
+    ImHui_Atlas *atlas = &imhui->atlas;
+    ImHui_Glyph_Page **page = &atlas->sizes[size].pages[codepoint / IMHUI_GLYPH_PAGE_SIZE];
+    const size_t index = codepoint % IMHUI_GLYPH_PAGE_SIZE;
+    const uint32_t bit = (uint32_t) 1 << (index % 32);
+    if (*page != NULL && ((*page)->present[index / 32] & bit) != 0) {
+        return &(*page)->uvs[index];
+    }
+
+    if (*page == NULL) {
+        *page = imhui_realloc(imhui, NULL, 0, sizeof(**page));
+        assert(*page != NULL && "imhui_atlas_glyph: out of memory");
+        memset((*page)->present, 0, sizeof((*page)->present));
+    }
+    (*page)->present[index / 32] |= bit;
+    ImHui_Glyph_UV *uv = &(*page)->uvs[index];
+
+    const size_t w = atlas->sizes[size].width;
+    const size_t h = atlas->sizes[size].height;
+    size_t x, y;
+    if (imhui_atlas_pack(imhui, w + IMHUI_ATLAS_PADDING, h + IMHUI_ATLAS_PADDING, &x, &y)) {
+        atlas->rasterize(atlas->user, codepoint, w, h, &atlas->pixels[y * IMHUI_ATLAS_WIDTH + x], IMHUI_ATLAS_WIDTH);
+        imhui_atlas_mark_dirty(atlas, x, y, w, h);
+        imhui_atlas_uv(uv, x, y, w, h);
+    } else {
+        // NOTE: the glyph is blank until the atlas is rebuilt on the next frame. The glyph
+        // that is larger than the whole atlas stays present and blank, so it is neither
+        // packed again nor makes the atlas rebuild every frame.
+        atlas->full = atlas->full ||
+                      (w + IMHUI_ATLAS_PADDING <= IMHUI_ATLAS_WIDTH && h + IMHUI_ATLAS_PADDING <= IMHUI_ATLAS_HEIGHT);
+        imhui_atlas_uv(uv, IMHUI_ATLAS_BLOCK + IMHUI_ATLAS_BLOCK / 2, IMHUI_ATLAS_BLOCK / 2, 0, 0);
+    }
+    return uv;
+}
+
+// `size` is the imhui_atlas_size() of the cell, ignored without the atlas
+static const ImHui_Glyph_UV *imhui_char_glyph(ImHui *imhui, uint32_t c, size_t size)
+{
+    if (imhui->sdf != NULL) {
+        // NOTE: the codepoints without a glyph get the solid rect, just like with FONT
+        const uint32_t index = c - imhui->sdf->first;
+        return &imhui->sdf->uvs[index < imhui->sdf->count ? index : imhui->sdf->count];
+    }
+    if (!imhui->atlas.active) {
+        return imhui_glyph_uv((int) (c < IMHUI_GLYPHS_COUNT + 32 ? c : FONT_SOLID_CHAR));
+    }
+    return imhui_atlas_glyph(imhui, size, c <= IMHUI_CODEPOINT_MAX ? c : IMHUI_CODEPOINT_REPLACEMENT);
+}
+
+// The UVs of the glyph `c` drawn into a cell of `size` pixels
+static void imhui_char_uv(ImHui *imhui, int c, Vec2 size, Vec2 *uv_p, Vec2 *uv_s)
+{
+    if (imhui->atlas.active && c == FONT_SOLID_CHAR) {
+        *uv_p = vec2((float) (IMHUI_ATLAS_BLOCK / 4) / (float) IMHUI_ATLAS_WIDTH,
+                     (float) (IMHUI_ATLAS_BLOCK / 4) / (float) IMHUI_ATLAS_HEIGHT);
+        *uv_s = vec2((float) (IMHUI_ATLAS_BLOCK / 2) / (float) IMHUI_ATLAS_WIDTH,
+                     (float) (IMHUI_ATLAS_BLOCK / 2) / (float) IMHUI_ATLAS_HEIGHT);
+        return;
+    }
+
+    const size_t cell = imhui->atlas.active ? imhui_atlas_size(imhui, imhui_atlas_cell(size.x), imhui_atlas_cell(size.y)) : 0;
+    const ImHui_Glyph_UV *glyph = imhui_char_glyph(imhui, (uint32_t) c, cell);
+    *uv_p = vec2(glyph->u, glyph->v);
+    *uv_s = vec2(glyph->du, glyph->dv);
+}
+
+#define IMHUI_LAYOUT_TREE_COLUMNS(X) \
+    X(type) X(start) X(size) X(padding) X(parent) X(first_child) X(next_sibling) X(subtree) X(flex)
+
+// All of the columns of the tree grow together to the same capacity
+static void imhui_layout_tree_reserve(ImHui *imhui, ImHui_Layout_Tree *tree, size_t required)
+{
+    size_t capacity = tree->capacity;
+#define IMHUI_LAYOUT_TREE_RESERVE(column) \
+    capacity = tree->capacity; \
+    tree->column = imhui_reserve(imhui, tree->column, sizeof(*tree->column), &capacity, required);
+    IMHUI_LAYOUT_TREE_COLUMNS(IMHUI_LAYOUT_TREE_RESERVE)
+#undef IMHUI_LAYOUT_TREE_RESERVE
+    tree->capacity = capacity;
+}
+
+static void imhui_layout_tree_free(ImHui *imhui, ImHui_Layout_Tree *tree)
+{
+#define IMHUI_LAYOUT_TREE_FREE(column) \
+    imhui_realloc(imhui, tree->column, tree->capacity * sizeof(*tree->column), 0);
+    IMHUI_LAYOUT_TREE_COLUMNS(IMHUI_LAYOUT_TREE_FREE)
+#undef IMHUI_LAYOUT_TREE_FREE
+    memset(tree, 0, sizeof(*tree));
+}
+
+void imhui_free(ImHui *imhui)
+{
+    imhui_realloc(imhui, imhui->vertices, imhui->vertices_capacity * sizeof(*imhui->vertices), 0);
+    imhui->vertices = NULL;
+    imhui->vertices_count = 0;
+    imhui->vertices_capacity = 0;
+
+    imhui_realloc(imhui, imhui->triangles, imhui->triangles_capacity * sizeof(*imhui->triangles), 0);
+    imhui->triangles = NULL;
+    imhui->triangles_count = 0;
+    imhui->triangles_capacity = 0;
+
+    imhui_realloc(imhui, imhui->quads, imhui->quads_capacity * sizeof(*imhui->quads), 0);
+    imhui->quads = NULL;
+    imhui->quads_count = 0;
+    imhui->quads_capacity = 0;
+
+    imhui_realloc(imhui, imhui->batches, imhui->batches_capacity * sizeof(*imhui->batches), 0);
+    imhui->batches = NULL;
+    imhui->batches_count = 0;
+    imhui->batches_capacity = 0;
+
+    imhui_realloc(imhui, imhui->prev_vertices, imhui->prev_vertices_capacity * sizeof(*imhui->prev_vertices), 0);
+    imhui->prev_vertices = NULL;
+    imhui->prev_vertices_count = 0;
+    imhui->prev_vertices_capacity = 0;
+
+    imhui_realloc(imhui, imhui->prev_triangles, imhui->prev_triangles_capacity * sizeof(*imhui->prev_triangles), 0);
+    imhui->prev_triangles = NULL;
+    imhui->prev_triangles_count = 0;
+    imhui->prev_triangles_capacity = 0;
+
+    imhui_realloc(imhui, imhui->prev_quads, imhui->prev_quads_capacity * sizeof(*imhui->prev_quads), 0);
+    imhui->prev_quads = NULL;
+    imhui->prev_quads_count = 0;
+    imhui->prev_quads_capacity = 0;
+
+    imhui_realloc(imhui, imhui->prev_batches, imhui->prev_batches_capacity * sizeof(*imhui->prev_batches), 0);
+    imhui->prev_batches = NULL;
+    imhui->prev_batches_count = 0;
+    imhui->prev_batches_capacity = 0;
+
+    imhui_realloc(imhui, imhui->hit_rects, imhui->hit_rects_capacity * sizeof(*imhui->hit_rects), 0);
+    imhui->hit_rects = NULL;
+    imhui->hit_rects_count = 0;
+    imhui->hit_rects_capacity = 0;
+
+    imhui_realloc(imhui, imhui->prev_hit_rects, imhui->prev_hit_rects_capacity * sizeof(*imhui->prev_hit_rects), 0);
+    imhui->prev_hit_rects = NULL;
+    imhui->prev_hit_rects_count = 0;
+    imhui->prev_hit_rects_capacity = 0;
+
+    imhui_table_free(imhui, &imhui->button_cache);
+    imhui_table_free(imhui, &imhui->text_cache);
+    imhui_table_free(imhui, &imhui->id_table);
+
+    imhui_realloc(imhui, imhui->flex_stack, imhui->flex_stack_capacity * sizeof(*imhui->flex_stack), 0);
+    imhui->flex_stack = NULL;
+    imhui->flex_stack_size = 0;
+    imhui->flex_stack_capacity = 0;
+
+    imhui_realloc(imhui, imhui->flex_items, imhui->flex_items_capacity * sizeof(*imhui->flex_items), 0);
+    imhui->flex_items = NULL;
+    imhui->flex_items_count = 0;
+    imhui->flex_items_capacity = 0;
+
+    imhui_table_free(imhui, &imhui->flex_cache);
+
+    imhui_table_free(imhui, &imhui->state_table);
+
+    imhui_realloc(imhui, imhui->atlas.pixels, IMHUI_ATLAS_WIDTH * IMHUI_ATLAS_HEIGHT, 0);
+    imhui->atlas.pixels = NULL;
+    imhui_atlas_free_sizes(imhui);
+    imhui_realloc(imhui, imhui->atlas.sizes, imhui->atlas.sizes_capacity * sizeof(*imhui->atlas.sizes), 0);
+    imhui->atlas.sizes = NULL;
+    imhui->atlas.sizes_capacity = 0;
+    imhui_realloc(imhui, imhui->atlas.shelves, imhui->atlas.shelves_capacity * sizeof(*imhui->atlas.shelves), 0);
+    imhui->atlas.shelves = NULL;
+    imhui->atlas.shelves_count = 0;
+    imhui->atlas.shelves_capacity = 0;
+    imhui->atlas.active = false;
+    for (size_t i = 0; i < imhui->state_pages_count; ++i) {
+        imhui_realloc(imhui, imhui->state_pages[i], IMHUI_STATE_PAGE_BLOCKS * IMHUI_STATE_SIZE, 0);
+    }
+    imhui_realloc(imhui, imhui->state_pages, imhui->state_pages_capacity * sizeof(*imhui->state_pages), 0);
+    imhui->state_pages = NULL;
+    imhui->state_pages_count = 0;
+    imhui->state_pages_capacity = 0;
+    imhui->state_free = NULL;
+    imhui->state_cursor = 0;
+
+    imhui_realloc(imhui, imhui->id_stack, imhui->id_stack_capacity * sizeof(*imhui->id_stack), 0);
+    imhui->id_stack = NULL;
+    imhui->id_stack_size = 0;
+    imhui->id_stack_capacity = 0;
+
+    imhui_realloc(imhui, imhui->layout_stack, imhui->layout_stack_capacity * sizeof(*imhui->layout_stack), 0);
+    imhui->layout_stack = NULL;
+    imhui->layout_stack_size = 0;
+    imhui->layout_stack_capacity = 0;
+    imhui_layout_tree_free(imhui, &imhui->layout);
+    imhui_layout_tree_free(imhui, &imhui->prev_layout);
+
+    imhui_realloc(imhui, imhui->subtree_stack, imhui->subtree_stack_capacity * sizeof(*imhui->subtree_stack), 0);
+    imhui->subtree_stack = NULL;
+    imhui->subtree_stack_size = 0;
+    imhui->subtree_stack_capacity = 0;
+    imhui_table_free(imhui, &imhui->subtree_cache);
+
+    imhui_realloc(imhui, imhui->clip_stack, imhui->clip_stack_capacity * sizeof(*imhui->clip_stack), 0);
+    imhui->clip_stack = NULL;
+    imhui->clip_stack_size = 0;
+    imhui->clip_stack_capacity = 0;
+}
+
+static size_t imhui_top_layout(ImHui *imhui)
+{
+    assert(imhui->layout_stack_size > 0);
+    return imhui->layout_stack[imhui->layout_stack_size - 1];
+}
+
+// Makes `node` the last child of the top layout and the new top layout
+static void imhui_layout_push(ImHui *imhui, size_t node)
+{
+    ImHui_Layout_Tree *tree = &imhui->layout;
+    if (imhui->layout_stack_size > 0) {
+        const size_t parent = imhui_top_layout(imhui);
+        if (tree->first_child[parent] == IMHUI_LAYOUT_NONE) {
+            tree->first_child[parent] = node;
+        } else {
+            tree->next_sibling[tree->next_sibling[parent]] = node;
+        }
+        tree->next_sibling[parent] = node;
+        tree->parent[node] = parent;
+    } else {
+        tree->parent[node] = IMHUI_LAYOUT_NONE;
+    }
+    tree->next_sibling[node] = IMHUI_LAYOUT_NONE;
+
+    imhui->layout_stack = imhui_reserve(
+                              imhui,
+                              imhui->layout_stack,
+                              sizeof(*imhui->layout_stack),
+                              &imhui->layout_stack_capacity,
+                              imhui->layout_stack_size + 1);
+    imhui->layout_stack[imhui->layout_stack_size++] = node;
+}
+
+// Ends the top layout and returns its node
+static size_t imhui_layout_pop(ImHui *imhui)
+{
+    const size_t node = imhui_top_layout(imhui);
+    imhui->layout_stack_size -= 1;
+    // NOTE: the sibling of the node follows once the parent is ended
+    imhui->layout.next_sibling[node] = IMHUI_LAYOUT_NONE;
+    return node;
+}
+
+static size_t imhui_layout_start(ImHui *imhui, ImHui_Layout_Type type, Vec2 start, float padding)
+{
+    ImHui_Layout_Tree *tree = &imhui->layout;
+    imhui_layout_tree_reserve(imhui, tree, tree->count + 1);
+    const size_t node = tree->count++;
+    tree->type[node] = type;
+    tree->start[node] = start;
+    tree->size[node] = vec2(0.0f, 0.0f);
+    tree->padding[node] = padding;
+    tree->first_child[node] = IMHUI_LAYOUT_NONE;
+    tree->subtree[node] = 0;
+    tree->flex[node] = false;
+    imhui_layout_push(imhui, node);
+    return node;
+}
+
+static Vec2 imhui_next_widget_position(ImHui *imhui)
+{
+    const ImHui_Layout_Tree *tree = &imhui->layout;
+    const size_t node = imhui_top_layout(imhui);
+    const Vec2 start = tree->start[node];
+    if (tree->flex[node]) {
+        return start;
+    }
+
+    switch (tree->type[node]) {
+    case IMHUI_VERT_LAYOUT:
+        return vec2(start.x, start.y + tree->size[node].y);
+    case IMHUI_HORZ_LAYOUT:
+        return vec2(start.x + tree->size[node].x, start.y);
+    default:
+        assert(false && "imhui_next_widget_position: unreachable");
+        exit(1);
+    }
+}
+
+static void imhui_expand_layout(ImHui *imhui, Vec2 widget_size)
+{
+    ImHui_Layout_Tree *tree = &imhui->layout;
+    const size_t node = imhui_top_layout(imhui);
+    Vec2 *size = &tree->size[node];
+    if (tree->flex[node]) {
+        size->x = widget_size.x > size->x ? widget_size.x : size->x;
+        size->y = widget_size.y > size->y ? widget_size.y : size->y;
+        return;
+    }
+
+    switch (tree->type[node]) {
+    case IMHUI_VERT_LAYOUT:
+        size->y += widget_size.y + tree->padding[node];
+        if (size->x < widget_size.x) {
+            size->x = widget_size.x;
+        }
+        break;
+    case IMHUI_HORZ_LAYOUT:
+        size->x += widget_size.x + tree->padding[node];
+        if (size->y < widget_size.y) {
+            size->y = widget_size.y;
+        }
+        break;
+    default:
+        assert(false && "imhui_expand_layout: unreachable");
+        exit(1);
+    }
+}
+
+void imhui_layout_begin(ImHui *imhui, ImHui_Layout_Type type, float padding)
+{
+    const Vec2 start = imhui_next_widget_position(imhui);
+    imhui_layout_start(imhui, type, start, padding);
+}
+
+void imhui_layout_end(ImHui *imhui)
+{
+    const size_t node = imhui_layout_pop(imhui);
+    if (imhui->layout_stack_size > 0) {
+        imhui_expand_layout(imhui, imhui->layout.size[node]);
+    }
+}
+
+static float imhui_axis(Vec2 v, size_t axis)
+{
+    return axis == 0 ? v.x : v.y;
+}
+
+// The vector of `length` along the `axis` and `cross` along the other one
+static Vec2 imhui_axes(size_t axis, float length, float cross)
+{
+    return axis == 0 ? vec2(length, cross) : vec2(cross, length);
+}
+
+static ImHui_Flex_Container *imhui_top_flex(ImHui *imhui)
+{
+    assert(imhui->flex_stack_size > 0 && "no matching imhui_flex_begin()");
+    return &imhui->flex_stack[imhui->flex_stack_size - 1];
+}
+
+static float imhui_flex_clamp(const ImHui_Flex_Item *item, float size)
+{
+    size = item->max > 0.0f && size > item->max ? item->max : size;
+    return size < item->min ? item->min : size;
+}
+
+// The items of the containers are cached by the ID of the container and their index
+static uint64_t imhui_flex_key(ImHui_ID id, size_t index)
+{
+    const uint64_t key = imhui_hash_u64(id ^ imhui_hash_u64(index + 1));
+    return key == 0 ? 1 : key;
+}
+
+void imhui_flex_begin(ImHui *imhui, ImHui_ID id, ImHui_Flex flex)
+{
+    assert(id != 0 && "imhui_flex_begin: the container needs an ID");
+    // NOTE: the containers with the same ID would share the cached slots of the items
+    imhui_check_id(imhui, id);
+
+    const Vec2 p = imhui_next_widget_position(imhui);
+    imhui->flex_stack = imhui_reserve(
+                            imhui,
+                            imhui->flex_stack,
+                            sizeof(*imhui->flex_stack),
+                            &imhui->flex_stack_capacity,
+                            imhui->flex_stack_size + 1);
+    imhui->flex_stack[imhui->flex_stack_size++] = (ImHui_Flex_Container) {
+        .id = id,
+        .flex = flex,
+        .position = p,
+        .first_item = imhui->flex_items_count,
+    };
+    const size_t node = imhui_layout_start(imhui, flex.direction, p, flex.padding);
+    imhui->layout.flex[node] = true;
+}
+
+// The current item ends where the next one starts
+static void imhui_flex_finish_item(ImHui *imhui, const ImHui_Flex_Container *container, size_t node)
+{
+    if (imhui->flex_items_count > container->first_item) {
+        imhui->flex_items[imhui->flex_items_count - 1].measured = imhui->layout.size[node];
+    }
+}
+
+Vec2 imhui_flex_item(ImHui *imhui, ImHui_Flex_Item item)
+{
+    const ImHui_Flex_Container *container = imhui_top_flex(imhui);
+    const size_t node = imhui_top_layout(imhui);
+    assert(imhui->layout.flex[node] && "imhui_flex_item: the item must be directly within imhui_flex_begin()");
+    imhui_flex_finish_item(imhui, container, node);
+
+    const size_t index = imhui->flex_items_count - container->first_item;
+    const size_t axis = container->flex.direction == IMHUI_HORZ_LAYOUT ? 0 : 1;
+    const ImHui_Flex_Cache *cache = imhui_table_insert(imhui, &imhui->flex_cache, sizeof(*cache), imhui_flex_key(container->id, index));
+
+    Vec2 position, size;
+    if (cache->slot.frame != 0) {
+        position = vec2(container->position.x + cache->offset.x, container->position.y + cache->offset.y);
+        size = cache->size;
+    } else if (index > 0) {
+        // NOTE: nothing is known about the item yet, so it goes right after the previous
+        // one as in a regular layout until imhui_flex_end() places it properly.
+        const ImHui_Flex_Record *prev = &imhui->flex_items[imhui->flex_items_count - 1];
+        const float length = imhui_axis(prev->position, axis) + imhui_axis(prev->measured, axis) + container->flex.padding;
+        position = imhui_axes(axis, length, imhui_axis(container->position, 1 - axis));
+        size = imhui_axes(axis, imhui_flex_clamp(&item, item.basis), 0.0f);
+    } else {
+        position = container->position;
+        size = imhui_axes(axis, imhui_flex_clamp(&item, item.basis), 0.0f);
+    }
+
+    imhui->flex_items = imhui_reserve(
+                            imhui,
+                            imhui->flex_items,
+                            sizeof(*imhui->flex_items),
+                            &imhui->flex_items_capacity,
+                            imhui->flex_items_count + 1);
+    imhui->flex_items[imhui->flex_items_count++] = (ImHui_Flex_Record) {
+        .item = item,
+        .position = position,
+        .nodes_first = imhui->layout.count,
+        .vertices_first = imhui->vertices_count,
+        .quads_first = imhui->quads_count,
+        .hit_rects_first = imhui->hit_rects_count,
+    };
+    imhui->layout.start[node] = position;
+    imhui->layout.size[node] = vec2(0.0f, 0.0f);
+    return size;
+}
+
+// Moves everything emitted by an item that ended up somewhere else than it was emitted at
+static void imhui_flex_move(ImHui *imhui, const ImHui_Flex_Record *record, const ImHui_Flex_Record *next, Vec2 delta)
+{
+    const size_t vertices_last = next != NULL ? next->vertices_first : imhui->vertices_count;
+    const size_t quads_last = next != NULL ? next->quads_first : imhui->quads_count;
+    const size_t hit_rects_last = next != NULL ? next->hit_rects_first : imhui->hit_rects_count;
+    const size_t nodes_last = next != NULL ? next->nodes_first : imhui->layout.count;
+
+    for (size_t i = record->nodes_first; i < nodes_last; ++i) {
+        imhui->layout.start[i].x += delta.x;
+        imhui->layout.start[i].y += delta.y;
+    }
+
+#ifdef IMHUI_PACKED_VERTICES
+    const int16_t dx = imhui_pack_pixel(delta.x);
+    const int16_t dy = imhui_pack_pixel(delta.y);
+    for (size_t i = record->vertices_first; i < vertices_last; ++i) {
+        imhui->vertices[i].position[0] += dx;
+        imhui->vertices[i].position[1] += dy;
+    }
+#else
+    for (size_t i = record->vertices_first; i < vertices_last; ++i) {
+        imhui->vertices[i].position.x += delta.x;
+        imhui->vertices[i].position.y += delta.y;
+    }
+#endif // IMHUI_PACKED_VERTICES
+
+    const int16_t qx = imhui_pack_pixel(delta.x);
+    const int16_t qy = imhui_pack_pixel(delta.y);
+    for (size_t i = record->quads_first; i < quads_last; ++i) {
+        imhui->quads[i].rect[0] += qx;
+        imhui->quads[i].rect[1] += qy;
+    }
+
+    for (size_t i = record->hit_rects_first; i < hit_rects_last; ++i) {
+        imhui->hit_rects[i].rect.x0 += delta.x;
+        imhui->hit_rects[i].rect.y0 += delta.y;
+        imhui->hit_rects[i].rect.x1 += delta.x;
+        imhui->hit_rects[i].rect.y1 += delta.y;
+    }
+}
+
+// Resolves the main sizes of the items the way flexbox does: the free space is shared
+// by the weights, and the items that hit their min or max are frozen at it one round
+// at a time until nothing violates its bounds.
+static void imhui_flex_resolve(ImHui_Flex_Record *items, size_t n, size_t axis, float space)
+{
+    float hypothetical = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        items[i].basis = items[i].item.basis > 0.0f ? items[i].item.basis : imhui_axis(items[i].measured, axis);
+        items[i].main_size = items[i].basis;
+        hypothetical += imhui_flex_clamp(&items[i].item, items[i].basis);
+    }
+    const bool growing = space > hypothetical;
+
+    for (size_t i = 0; i < n; ++i) {
+        const float weight = growing ? items[i].item.grow : items[i].item.shrink;
+        items[i].frozen = weight <= 0.0f;
+        if (items[i].frozen) {
+            items[i].main_size = imhui_flex_clamp(&items[i].item, items[i].main_size);
+        }
+    }
+
+    for (size_t round = 0; round <= n; ++round) {
+        float free = space;
+        float weights = 0.0f;
+        for (size_t i = 0; i < n; ++i) {
+            free -= items[i].basis;
+            if (!items[i].frozen) {
+                weights += growing ? items[i].item.grow : items[i].item.shrink * items[i].basis;
+            } else {
+                free += items[i].basis - items[i].main_size;
+            }
+        }
+        if (weights <= 0.0f) {
+            break;
+        }
+
+        float violation = 0.0f;
+        for (size_t i = 0; i < n; ++i) {
+            if (items[i].frozen) {
+                continue;
+            }
+            const float weight = growing ? items[i].item.grow : items[i].item.shrink * items[i].basis;
+            const float size = items[i].basis + free * weight / weights;
+            items[i].main_size = imhui_flex_clamp(&items[i].item, size > 0.0f ? size : 0.0f);
+            violation += items[i].main_size - size;
+        }
+        if (violation == 0.0f) {
+            break;
+        }
+
+        // NOTE: only the items violating in the direction of the total are frozen this round
+        for (size_t i = 0; i < n; ++i) {
+            if (!items[i].frozen) {
+                const float weight = growing ? items[i].item.grow : items[i].item.shrink * items[i].basis;
+                const float size = items[i].basis + free * weight / weights;
+                const float clamped = items[i].main_size - (size > 0.0f ? size : 0.0f);
+                items[i].frozen = violation > 0.0f ? clamped > 0.0f : clamped < 0.0f;
+            }
+        }
+    }
+}
+
+void imhui_flex_end(ImHui *imhui)
+{
+    const ImHui_Flex_Container container = *imhui_top_flex(imhui);
+    const size_t node = imhui_top_layout(imhui);
+    assert(imhui->layout.flex[node] && "imhui_flex_end: the layouts within the container are not balanced");
+    imhui_flex_finish_item(imhui, &container, node);
+
+    ImHui_Flex_Record *items = &imhui->flex_items[container.first_item];
+    const size_t n = imhui->flex_items_count - container.first_item;
+    const size_t axis = container.flex.direction == IMHUI_HORZ_LAYOUT ? 0 : 1;
+    const float gaps = n > 1 ? container.flex.padding * (float) (n - 1) : 0.0f;
+
+    float content = gaps;
+    float cross = imhui_axis(container.flex.size, 1 - axis);
+    const bool fit_cross = cross <= 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        const float basis = items[i].item.basis > 0.0f ? items[i].item.basis : imhui_axis(items[i].measured, axis);
+        content += imhui_flex_clamp(&items[i].item, basis);
+        if (fit_cross && imhui_axis(items[i].measured, 1 - axis) > cross) {
+            cross = imhui_axis(items[i].measured, 1 - axis);
+        }
+    }
+    const float length = imhui_axis(container.flex.size, axis) > 0.0f ? imhui_axis(container.flex.size, axis) : content;
+    imhui_flex_resolve(items, n, axis, length - gaps);
+
+    float used = gaps;
+    for (size_t i = 0; i < n; ++i) {
+        used += items[i].main_size;
+    }
+    const float free = length - used;
+    float cursor = 0.0f;
+    float spacing = container.flex.padding;
+    switch (container.flex.justify) {
+    case IMHUI_FLEX_CENTER:
+        cursor = free * 0.5f;
+        break;
+    case IMHUI_FLEX_END:
+        cursor = free;
+        break;
+    case IMHUI_FLEX_SPACE_BETWEEN:
+        spacing += n > 1 && free > 0.0f ? free / (float) (n - 1) : 0.0f;
+        break;
+    default:
+        break;
+    }
+
+    bool moved = false;
+    for (size_t i = 0; i < n; ++i) {
+        ImHui_Flex_Record *record = &items[i];
+        const float measured_cross = imhui_axis(record->measured, 1 - axis);
+        float slot_cross = measured_cross;
+        float offset_cross = 0.0f;
+        switch (record->item.align) {
+        case IMHUI_FLEX_CENTER:
+            offset_cross = (cross - measured_cross) * 0.5f;
+            break;
+        case IMHUI_FLEX_END:
+            offset_cross = cross - measured_cross;
+            break;
+        case IMHUI_FLEX_STRETCH:
+            slot_cross = cross;
+            break;
+        default:
+            break;
+        }
+
+        const Vec2 offset = imhui_axes(axis, cursor, offset_cross);
+        cursor += record->main_size + spacing;
+
+        ImHui_Flex_Cache *cache = imhui_table_insert(imhui, &imhui->flex_cache, sizeof(*cache), imhui_flex_key(container.id, i));
+        cache->offset = offset;
+        cache->size = imhui_axes(axis, record->main_size, slot_cross);
+        imhui_table_touch(&imhui->flex_cache, cache, imhui->frame);
+
+        const Vec2 delta = vec2(container.position.x + offset.x - record->position.x,
+                                container.position.y + offset.y - record->position.y);
+        if (delta.x != 0.0f || delta.y != 0.0f) {
+            imhui_flex_move(imhui, record, i + 1 < n ? &items[i + 1] : NULL, delta);
+            moved = true;
+        }
+    }
+    if (moved) {
+        imhui->flex_moved_frame = imhui->frame;
+    }
+
+    imhui->flex_items_count = container.first_item;
+    imhui->flex_stack_size -= 1;
+    imhui->layout.start[node] = container.position;
+    imhui->layout.size[node] = imhui_axes(axis, length, cross);
+    imhui_layout_end(imhui);
+}
+
+static void imhui_clip_push(ImHui *imhui, ImHui_Clip clip)
+{
+    imhui->clip_stack = imhui_reserve(
+                            imhui,
+                            imhui->clip_stack,
+                            sizeof(*imhui->clip_stack),
+                            &imhui->clip_stack_capacity,
+                            imhui->clip_stack_size + 1);
+    imhui->clip_stack[imhui->clip_stack_size++] = clip;
+}
+
+static const ImHui_Clip *imhui_top_clip(const ImHui *imhui)
+{
+    assert(imhui->clip_stack_size > 0);
+    return &imhui->clip_stack[imhui->clip_stack_size - 1];
+}
+
+static bool imhui_clip_contains(const ImHui_Clip *clip, Vec2 t)
+{
+    return clip->x0 <= t.x && t.x < clip->x1 &&
+           clip->y0 <= t.y && t.y < clip->y1;
+}
+
+static bool imhui_clip_overlaps(const ImHui_Clip *clip, Vec2 p, Vec2 s)
+{
+    return p.x < clip->x1 && clip->x0 < p.x + s.x &&
+           p.y < clip->y1 && clip->y0 < p.y + s.y;
+}
+
+static bool imhui_same_clip(const ImHui_Clip *a, const ImHui_Clip *b)
+{
+    return a->x0 == b->x0 && a->y0 == b->y0 && a->x1 == b->x1 && a->y1 == b->y1;
+}
+
+static ImHui_Clip imhui_clip_intersect(const ImHui_Clip *clip, Vec2 p, Vec2 s)
+{
+    ImHui_Clip result = {
+        .x0 = p.x > clip->x0 ? p.x : clip->x0,
+        .y0 = p.y > clip->y0 ? p.y : clip->y0,
+        .x1 = p.x + s.x < clip->x1 ? p.x + s.x : clip->x1,
+        .y1 = p.y + s.y < clip->y1 ? p.y + s.y : clip->y1,
+    };
+    // NOTE: an empty clip rect is kept non-inverted, so nothing can overlap it
+    result.x1 = result.x1 > result.x0 ? result.x1 : result.x0;
+    result.y1 = result.y1 > result.y0 ? result.y1 : result.y0;
+    return result;
+}
+
+void imhui_clip_begin(ImHui *imhui, Vec2 p, Vec2 s)
+{
+    imhui_clip_push(imhui, imhui_clip_intersect(imhui_top_clip(imhui), p, s));
+}
+
+void imhui_clip_end(ImHui *imhui)
+{
+    assert(imhui->clip_stack_size > 1 && "imhui_clip_end: no matching imhui_clip_begin");
+    imhui->clip_stack_size -= 1;
+}
+
+// NOTE: the hover check of a widget is a comparison of IDs. The single point query against
+// all of the recorded rects happens once per frame in imhui_resolve_hot().
+bool imhui_hovered(ImHui *imhui, ImHui_ID id, Vec2 p, Vec2 s)
+{
+    const ImHui_Clip rect = imhui_clip_intersect(imhui_top_clip(imhui), p, s);
+    if (rect.x0 < rect.x1 && rect.y0 < rect.y1) {
+        imhui->hit_rects = imhui_reserve(
+                               imhui,
+                               imhui->hit_rects,
+                               sizeof(*imhui->hit_rects),
+                               &imhui->hit_rects_capacity,
+                               imhui->hit_rects_count + 1);
+        imhui->hit_rects[imhui->hit_rects_count++] = (ImHui_Hit_Rect) {
+            .id = id,
+            .rect = rect,
+        };
+    }
+    return id != 0 && imhui->hot == id;
+}
+
+// The widgets are drawn in the order they are recorded, so the last rect under the
+// mouse belongs to the topmost widget and the backward scan can stop at it.
+static void imhui_resolve_hot(ImHui *imhui)
+{
+    imhui->hot = 0;
+    for (size_t i = imhui->prev_hit_rects_count; i > 0; --i) {
+        const ImHui_Hit_Rect *hit = &imhui->prev_hit_rects[i - 1];
+        if (imhui_clip_contains(&hit->rect, imhui->mouse_pos)) {
+            imhui->hot = hit->id;
+            break;
+        }
+    }
+
+    // NOTE: only needed by the subtrees, which can tell whether the active widget is
+    // within them by its rect. Nothing is active most of the time.
+    imhui->active_hidden = imhui->active != 0;
+    for (size_t i = 0; imhui->active_hidden && i < imhui->prev_hit_rects_count; ++i) {
+        imhui->active_hidden = imhui->prev_hit_rects[i].id != imhui->active;
+    }
+}
+
+void imhui_clipper_begin(ImHui *imhui, ImHui_Clipper *clipper, size_t rows_count, float row_height)
+{
+    const ImHui_Layout_Tree *tree = &imhui->layout;
+    const size_t node = imhui_top_layout(imhui);
+    assert(tree->type[node] == IMHUI_VERT_LAYOUT && "imhui_clipper_begin: the rows must be in a vertical layout");
+
+    *clipper = (ImHui_Clipper) {
+        .rows_count = rows_count,
+        .measure = row_height <= 0.0f,
+        .advance = row_height > 0.0f ? row_height + tree->padding[node] : 0.0f,
+        .start = tree->start[node].y + tree->size[node].y,
+    };
+}
+
+bool imhui_clipper_step(ImHui *imhui, ImHui_Clipper *clipper)
+{
+    const size_t node = imhui_top_layout(imhui);
+    const float start = imhui->layout.start[node].y;
+    Vec2 *size = &imhui->layout.size[node];
+    clipper->step += 1;
+
+    if (clipper->measure && clipper->step == 1 && clipper->rows_count > 0) {
+        clipper->first = 0;
+        clipper->last = 1;
+        return true;
+    }
+
+    if (clipper->step == (clipper->measure ? 2u : 1u)) {
+        if (clipper->measure) {
+            clipper->advance = start + size->y - clipper->start;
+        }
+
+        // The rows that overlap the clip vertically, after the already emitted ones. The widgets
+        // may draw a bit outside of their rows (e.g. the offset of the buttons), so one more row
+        // is emitted on each side. NOTE: without a positive advance nothing can be skipped.
+        size_t first = clipper->last;
+        size_t last = clipper->rows_count;
+        if (clipper->advance > 0.0f) {
+            const ImHui_Clip *clip = imhui_top_clip(imhui);
+            const float rows = (float) clipper->rows_count;
+            const float from = (clip->y0 - clipper->start) / clipper->advance - 1.0f;
+            const float to = (clip->y1 - clipper->start) / clipper->advance + 2.0f;
+            const size_t visible_first = from > 0.0f ? (from < rows ? (size_t) from : clipper->rows_count) : 0;
+            const size_t visible_last = to > 0.0f ? (to < rows ? (size_t) to : clipper->rows_count) : 0;
+            first = visible_first > first ? visible_first : first;
+            last = visible_last;
+        }
+
+        if (first < last) {
+            size->y = clipper->start + first * clipper->advance - start;
+            clipper->first = first;
+            clipper->last = last;
+            return true;
+        }
+    }
+
+    if (clipper->advance > 0.0f) {
+        size->y = clipper->start + clipper->rows_count * clipper->advance - start;
+    }
+    clipper->first = clipper->last = clipper->rows_count;
+    return false;
+}
+
+void imhui_panel_begin(ImHui *imhui, Vec2 size, float scroll, float padding)
+{
+    const Vec2 p = imhui_next_widget_position(imhui);
+    imhui_expand_layout(imhui, size);
+    imhui_clip_begin(imhui, p, size);
+    imhui_layout_start(imhui, IMHUI_VERT_LAYOUT, vec2(p.x, p.y - scroll), padding);
+}
+
+void imhui_panel_end(ImHui *imhui)
+{
+    // NOTE: the parent layout already got the fixed size of the panel
+    assert(imhui->layout_stack_size > 1);
+    imhui_layout_pop(imhui);
+    imhui_clip_end(imhui);
+}
+
+static ImHui_Batch *imhui_top_batch(ImHui *imhui)
+{
+    assert(imhui->batches_count > 0);
+    return &imhui->batches[imhui->batches_count - 1];
+}
+
+static void imhui_push_batch(ImHui *imhui)
+{
+    imhui->batches = imhui_reserve(
+                         imhui,
+                         imhui->batches,
+                         sizeof(*imhui->batches),
+                         &imhui->batches_capacity,
+                         imhui->batches_count + 1);
+    imhui->batches[imhui->batches_count++] = (ImHui_Batch) {
+        .base_vertex = imhui->vertices_count,
+        .first_triangle = imhui->triangles_count,
+        .first_quad = imhui->quads_count,
+        .clip = *imhui_top_clip(imhui),
+        .texture = imhui->texture,
+    };
+}
+
+// Whether the geometry emitted now can be appended to the current batch
+static bool imhui_top_batch_matches(ImHui *imhui)
+{
+    if (imhui->batches_count == 0) {
+        return false;
+    }
+    const ImHui_Batch *batch = imhui_top_batch(imhui);
+    return batch->callback == NULL &&
+           batch->texture == imhui->texture &&
+           imhui_same_clip(&batch->clip, imhui_top_clip(imhui));
+}
+
+// Reserves the space for the vertices and the triangles that are going to be appended,
+// starting a new batch if the vertices would overflow ImHui_Index or the state changed.
+static void imhui_reserve_geometry(ImHui *imhui, size_t vertices_count, size_t triangles_count)
+{
+    assert(vertices_count > 0 && vertices_count - 1 <= IMHUI_INDEX_MAX);
+
+    imhui->vertices = imhui_reserve(
+                          imhui,
+                          imhui->vertices,
+                          sizeof(*imhui->vertices),
+                          &imhui->vertices_capacity,
+                          imhui->vertices_count + vertices_count);
+    imhui->triangles = imhui_reserve(
+                           imhui,
+                           imhui->triangles,
+                           sizeof(*imhui->triangles),
+                           &imhui->triangles_capacity,
+                           imhui->triangles_count + triangles_count);
+
+    if (!imhui_top_batch_matches(imhui) ||
+            imhui->vertices_count + vertices_count - 1 - imhui_top_batch(imhui)->base_vertex > IMHUI_INDEX_MAX) {
+        imhui_push_batch(imhui);
+    }
+}
+
+// The same as imhui_reserve_geometry() for the instanced mode
+static void imhui_reserve_quads(ImHui *imhui, size_t quads_count)
+{
+    imhui->quads = imhui_reserve(
+                       imhui,
+                       imhui->quads,
+                       sizeof(*imhui->quads),
+                       &imhui->quads_capacity,
+                       imhui->quads_count + quads_count);
+
+    if (!imhui_top_batch_matches(imhui)) {
+        imhui_push_batch(imhui);
+    }
+}
+
+// Returns the index of the first appended vertex relative to the current batch
+static ImHui_Index imhui_append_vertices(ImHui *imhui, const Vertex *vs, size_t n)
+{
+    assert(imhui->vertices_count + n <= imhui->vertices_capacity);
+    ImHui_Index result = (ImHui_Index) (imhui->vertices_count - imhui_top_batch(imhui)->base_vertex);
+    memcpy(imhui->vertices + imhui->vertices_count, vs, n * sizeof(*vs));
+    imhui->vertices_count += n;
+    return result;
+}
+
+static void imhui_append_triangle(ImHui *imhui, Triangle t)
+{
+    assert(imhui->triangles_count < imhui->triangles_capacity);
+    imhui->triangles[imhui->triangles_count++] = t;
+}
+
+// Builds the 4 corners of an axis aligned quad in the order p0 = top-left,
+// p1 = top-right, p2 = bottom-left, p3 = bottom-right.
+static void imhui_quad_vertices(Vertex quad[4], Vec2 p, Vec2 s, RGBA c, Vec2 uv_p, Vec2 uv_s)
+{
+#ifdef IMHUI_PACKED_VERTICES
+    const int16_t x0 = imhui_pack_pixel(p.x);
+    const int16_t y0 = imhui_pack_pixel(p.y);
+    const int16_t x1 = imhui_pack_pixel(p.x + s.x);
+    const int16_t y1 = imhui_pack_pixel(p.y + s.y);
+    const uint16_t u0 = imhui_pack_unorm16(uv_p.x);
+    const uint16_t v0 = imhui_pack_unorm16(uv_p.y);
+    const uint16_t u1 = imhui_pack_unorm16(uv_p.x + uv_s.x);
+    const uint16_t v1 = imhui_pack_unorm16(uv_p.y + uv_s.y);
+    const uint8_t r = imhui_pack_unorm8(c.r);
+    const uint8_t g = imhui_pack_unorm8(c.g);
+    const uint8_t b = imhui_pack_unorm8(c.b);
+    const uint8_t a = imhui_pack_unorm8(c.a);
+
+    // NOTE: every component is packed once per quad rather than once per vertex
+    quad[0] = (Vertex) {{x0, y0}, {r, g, b, a}, {u0, v0}};
+    quad[1] = (Vertex) {{x1, y0}, {r, g, b, a}, {u1, v0}};
+    quad[2] = (Vertex) {{x0, y1}, {r, g, b, a}, {u0, v1}};
+    quad[3] = (Vertex) {{x1, y1}, {r, g, b, a}, {u1, v1}};
+#else
+    quad[0] = vertex(p, c, uv_p);
+    quad[1] = vertex(vec2(p.x + s.x, p.y), c, vec2(uv_p.x + uv_s.x, uv_p.y));
+    quad[2] = vertex(vec2(p.x, p.y + s.y), c, vec2(uv_p.x, uv_p.y + uv_s.y));
+    quad[3] = vertex(vec2(p.x + s.x, p.y + s.y), c, vec2(uv_p.x + uv_s.x, uv_p.y + uv_s.y));
+#endif // IMHUI_PACKED_VERTICES
+}
+
+// Trims the rect to the clip and moves its UVs along. Returns false when nothing is left.
+static bool imhui_clip_rect(const ImHui_Clip *clip, Vec2 *p, Vec2 *s, Vec2 *uv_p, Vec2 *uv_s)
+{
+    const float x0 = p->x;
+    const float y0 = p->y;
+    const float x1 = p->x + s->x;
+    const float y1 = p->y + s->y;
+    if (clip->x0 <= x0 && clip->y0 <= y0 && x1 <= clip->x1 && y1 <= clip->y1) {
+        return true;
+    }
+
+    const float cx0 = x0 > clip->x0 ? x0 : clip->x0;
+    const float cy0 = y0 > clip->y0 ? y0 : clip->y0;
+    const float cx1 = x1 < clip->x1 ? x1 : clip->x1;
+    const float cy1 = y1 < clip->y1 ? y1 : clip->y1;
+    if (cx0 >= cx1 || cy0 >= cy1) {
+        return false;
+    }
+
+    const Vec2 du = vec2(uv_s->x / s->x, uv_s->y / s->y);
+    *uv_p = vec2(uv_p->x + (cx0 - x0) * du.x, uv_p->y + (cy0 - y0) * du.y);
+    *uv_s = vec2((cx1 - cx0) * du.x, (cy1 - cy0) * du.y);
+    *p = vec2(cx0, cy0);
+    *s = vec2(cx1 - cx0, cy1 - cy0);
+    return true;
+}
+
+static void imhui_fill_rect_uv(ImHui *imhui, Vec2 p, Vec2 s, RGBA c, Vec2 uv_p, Vec2 uv_s)
+{
+    if (!imhui_clip_rect(imhui_top_clip(imhui), &p, &s, &uv_p, &uv_s)) {
+        return;
+    }
+
+    if (imhui->instanced) {
+        imhui_reserve_quads(imhui, 1);
+        imhui->quads[imhui->quads_count++] = quad(p, s, c, uv_p, uv_s);
+        return;
+    }
+
+    imhui_reserve_geometry(imhui, 4, 2);
+
+    Vertex quad[4];
+    imhui_quad_vertices(quad, p, s, c, uv_p, uv_s);
+
+    const ImHui_Index p0 = imhui_append_vertices(imhui, quad, 4);
+    const ImHui_Index p1 = p0 + 1;
+    const ImHui_Index p2 = p0 + 2;
+    const ImHui_Index p3 = p0 + 3;
+
+    imhui_append_triangle(imhui, triangle(p0, p1, p2));
+    imhui_append_triangle(imhui, triangle(p1, p2, p3));
+}
+
+static void imhui_fill_rect_char(ImHui *imhui, Vec2 p, Vec2 s, RGBA c, int ch)
+{
+    Vec2 uv_p, uv_s;
+    imhui_char_uv(imhui, ch, s, &uv_p, &uv_s);
+    imhui_fill_rect_uv(imhui, p, s, c, uv_p, uv_s);
+}
+
+static void imhui_fill_rect(ImHui *imhui, Vec2 p, Vec2 s, RGBA c)
+{
+    imhui_fill_rect_char(imhui, p, s, c, FONT_SOLID_CHAR);
+}
+
+void imhui_render_char(ImHui *imhui, Vec2 p, float s, RGBA color, int ch)
+{
+    imhui_fill_rect_char(imhui, p, vec2((float) FONT_CHAR_WIDTH * s, (float) FONT_CHAR_HEIGHT * s), color, ch);
+}
+
+// The glyphs of a run are either the bytes of ASCII text or decoded `codepoints`
+static uint32_t imhui_run_codepoint(const char *text, const uint32_t *codepoints, size_t i)
+{
+    return codepoints != NULL ? codepoints[i] : (unsigned char) text[i];
+}
+
+// TODO(#6): consider rendering the text with bitmap textures instead of triangle
+// It's too many god damn triangles
+static void imhui_render_glyphs(ImHui *imhui, Vec2 p, float s, RGBA color, const char *text, const uint32_t *codepoints, size_t n)
+{
+    // NOTE: the whole run is emitted by a single loop without any per glyph calls.
+    // Everything that is the same for all of the glyphs is computed once up front.
+    const Vec2 size = vec2((float) FONT_CHAR_WIDTH * s, (float) FONT_CHAR_HEIGHT * s);
+    const float advance = s * FONT_CHAR_WIDTH;
+    const bool atlas = imhui->atlas.active;
+    // NOTE: only the glyphs of FONT are all of the same size in the texture
+    const bool sized_uvs = atlas || imhui->sdf != NULL;
+
+    if (n == 0) {
+        return;
+    }
+
+    const ImHui_Clip *clip = imhui_top_clip(imhui);
+    const float x1 = p.x + (n - 1) * advance + size.x;
+    if (p.x < clip->x0 || p.y < clip->y0 || x1 > clip->x1 || p.y + size.y > clip->y1) {
+        if (p.y >= clip->y1 || p.y + size.y <= clip->y0) {
+            return;
+        }
+
+        // NOTE: only the glyphs that overlap the clip horizontally are visited,
+        // and each of them is trimmed separately.
+        const float from = (clip->x0 - p.x) / advance;
+        const float to = (clip->x1 - p.x) / advance + 1.0f;
+        const size_t first = from > 0.0f ? (size_t) from : 0;
+        const size_t last = to < (float) n ? (to > 0.0f ? (size_t) to : 0) : n;
+        for (size_t i = first; i < last; ++i) {
+            imhui_fill_rect_char(imhui, vec2(p.x + i * advance, p.y), size, color, (int) imhui_run_codepoint(text, codepoints, i));
+        }
+        return;
+    }
+
+    const size_t cell = atlas ? imhui_atlas_size(imhui, imhui_atlas_cell(size.x), imhui_atlas_cell(size.y)) : 0;
+    if (imhui->instanced) {
+        imhui_reserve_quads(imhui, n);
+
+        const Quad prototype = quad(p, size, color, vec2(0.0f, 0.0f), vec2(IMHUI_GLYPH_DU, IMHUI_GLYPH_DV));
+        Quad *quads = imhui->quads + imhui->quads_count;
+        for (size_t i = 0; i < n; ++i) {
+            const ImHui_Glyph_UV *glyph = imhui_char_glyph(imhui, imhui_run_codepoint(text, codepoints, i), cell);
+            quads[i] = prototype;
+            quads[i].rect[0] = imhui_pack_pixel(p.x + i * advance);
+            quads[i].uv[0] = glyph->u0;
+            quads[i].uv[1] = glyph->v0;
+            if (sized_uvs) {
+                // NOTE: the glyphs that did not fit into the atlas have an empty UV rect
+                quads[i].uv[2] = glyph->u1 - glyph->u0;
+                quads[i].uv[3] = glyph->v1 - glyph->v0;
+            }
+        }
+        imhui->quads_count += n;
+        return;
+    }
+
+#ifdef IMHUI_PACKED_VERTICES
+    const int16_t y0 = imhui_pack_pixel(p.y);
+    const int16_t y1 = imhui_pack_pixel(p.y + size.y);
+    const uint8_t r = imhui_pack_unorm8(color.r);
+    const uint8_t g = imhui_pack_unorm8(color.g);
+    const uint8_t b = imhui_pack_unorm8(color.b);
+    const uint8_t a = imhui_pack_unorm8(color.a);
+#endif // IMHUI_PACKED_VERTICES
+
+    // A run is split when it does not fit into a single batch
+    const size_t RUN_MAX = IMHUI_INDEX_MAX / 4 + 1;
+    for (size_t first = 0; first < n; first += RUN_MAX) {
+        const size_t run = n - first < RUN_MAX ? n - first : RUN_MAX;
+        imhui_reserve_geometry(imhui, run * 4, run * 2);
+
+        Vertex *vs = imhui->vertices + imhui->vertices_count;
+        Triangle *ts = imhui->triangles + imhui->triangles_count;
+        const ImHui_Index base = (ImHui_Index) (imhui->vertices_count - imhui_top_batch(imhui)->base_vertex);
+
+        for (size_t i = 0; i < run; ++i) {
+            const ImHui_Glyph_UV *glyph = imhui_char_glyph(imhui, imhui_run_codepoint(text, codepoints, first + i), cell);
+            const float x0 = p.x + (first + i) * advance;
+            const float x1 = x0 + size.x;
+#ifdef IMHUI_PACKED_VERTICES
+            const int16_t px0 = imhui_pack_pixel(x0);
+            const int16_t px1 = imhui_pack_pixel(x1);
+            vs[4 * i + 0] = (Vertex) {{px0, y0}, {r, g, b, a}, {glyph->u0, glyph->v0}};
+            vs[4 * i + 1] = (Vertex) {{px1, y0}, {r, g, b, a}, {glyph->u1, glyph->v0}};
+            vs[4 * i + 2] = (Vertex) {{px0, y1}, {r, g, b, a}, {glyph->u0, glyph->v1}};
+            vs[4 * i + 3] = (Vertex) {{px1, y1}, {r, g, b, a}, {glyph->u1, glyph->v1}};
+#else
+            const float y1 = p.y + size.y;
+            const float u1 = glyph->u + glyph->du;
+            const float v1 = glyph->v + glyph->dv;
+            vs[4 * i + 0] = (Vertex) {{x0, p.y}, color, {glyph->u, glyph->v}};
+            vs[4 * i + 1] = (Vertex) {{x1, p.y}, color, {u1, glyph->v}};
+            vs[4 * i + 2] = (Vertex) {{x0, y1}, color, {glyph->u, v1}};
+            vs[4 * i + 3] = (Vertex) {{x1, y1}, color, {u1, v1}};
+#endif // IMHUI_PACKED_VERTICES
+
+            const ImHui_Index p0 = (ImHui_Index) (base + 4 * i);
+            ts[2 * i + 0] = (Triangle) {p0, p0 + 1, p0 + 2};
+            ts[2 * i + 1] = (Triangle) {p0 + 1, p0 + 2, p0 + 3};
+        }
+
+        imhui->vertices_count += run * 4;
+        imhui->triangles_count += run * 2;
+    }
+}
+
+#define IMHUI_RUN_CHUNK 256
+
+// NOTE: ASCII goes straight from the bytes to the glyphs. Only the text after the first
+// non-ASCII byte is decoded, a chunk of codepoints at a time.
+static void imhui_render_run(ImHui *imhui, Vec2 p, float s, RGBA color, const char *text, size_t n)
+{
+    const size_t ascii = imhui_utf8_ascii(text, n);
+    imhui_render_glyphs(imhui, p, s, color, text, NULL, ascii);
+    p.x += ascii * s * FONT_CHAR_WIDTH;
+
+    uint32_t codepoints[IMHUI_RUN_CHUNK];
+    for (size_t i = ascii; i < n;) {
+        size_t count = 0;
+        while (i < n && count < IMHUI_RUN_CHUNK) {
+            size_t len;
+            codepoints[count++] = imhui_utf8_decode(text + i, n - i, &len);
+            i += len;
+        }
+        imhui_render_glyphs(imhui, p, s, color, text, codepoints, count);
+        p.x += count * s * FONT_CHAR_WIDTH;
+    }
+}
+
+void imhui_render_text_len(ImHui *imhui, Vec2 p, float s, RGBA color, const char *text, size_t n)
+{
+    // Every line is a separate run
+    for (const char *newline = memchr(text, '\n', n); newline != NULL; newline = memchr(text, '\n', n)) {
+        const size_t run = newline - text;
+        imhui_render_run(imhui, p, s, color, text, run);
+        p.y += FONT_CHAR_HEIGHT * s;
+        text += run + 1;
+        n -= run + 1;
+    }
+    imhui_render_run(imhui, p, s, color, text, n);
+}
+
+void imhui_render_text(ImHui *imhui, Vec2 p, float s, RGBA color, const char *text)
+{
+    imhui_render_text_len(imhui, p, s, color, text, strlen(text));
+}
+
+static ImHui_Text_Metrics imhui_text_metrics(ImHui *imhui, const char *text, uint64_t hash, size_t n, float s)
+{
+    uint64_t key = imhui_hash_u64(hash ^ n);
+    key = key == 0 ? 1 : key;
+
+    ImHui_Text_Cache *cache = imhui_table_insert(imhui, &imhui->text_cache, sizeof(*cache), key);
+    if (cache->slot.frame == 0 || cache->hash != hash || cache->length != n) {
+        cache->hash = hash;
+        cache->length = n;
+        cache->glyphs = 0;
+        cache->lines = 1;
+        cache->columns = 0;
+
+        size_t line_start = 0;
+        for (const char *newline = memchr(text, '\n', n); newline != NULL; newline = memchr(newline + 1, '\n', n - (newline + 1 - text))) {
+            const size_t line_end = newline - text;
+            const size_t columns = imhui_utf8_length(text + line_start, line_end - line_start);
+            cache->glyphs += columns;
+            cache->columns = columns > cache->columns ? columns : cache->columns;
+            cache->lines += 1;
+            line_start = line_end + 1;
+        }
+        const size_t columns = imhui_utf8_length(text + line_start, n - line_start);
+        cache->glyphs += columns;
+        cache->columns = columns > cache->columns ? columns : cache->columns;
+    }
+    imhui_table_touch(&imhui->text_cache, cache, imhui->frame);
+
+    return (ImHui_Text_Metrics) {
+        .length = cache->length,
+        .glyphs = cache->glyphs,
+        .lines = cache->lines,
+        .size = vec2(FONT_CHAR_WIDTH * s * cache->columns, FONT_CHAR_HEIGHT * s * cache->lines),
+        .hash = hash,
+    };
+}
+
+ImHui_Text_Metrics imhui_measure_text(ImHui *imhui, const char *text, float s)
+{
+    size_t n = 0;
+    const uint64_t hash = imhui_hash_cstr(text, &n);
+    return imhui_text_metrics(imhui, text, hash, n, s);
+}
+
+ImHui_Text_Metrics imhui_measure_text_len(ImHui *imhui, const char *text, size_t n, float s)
+{
+    return imhui_text_metrics(imhui, text, imhui_hash_bytes(text, n), n, s);
+}
+
+void imhui_mouse_down(ImHui *imhui)
+{
+    imhui->mouse_buttons = imhui->mouse_buttons | BUTTON_LEFT;
+}
+
+void imhui_mouse_up(ImHui *imhui)
+{
+    imhui->mouse_buttons = imhui->mouse_buttons & (~BUTTON_LEFT);
+}
+
+void imhui_mouse_scroll(ImHui *imhui, float dy)
+{
+    imhui->mouse_scroll += dy;
+}
+
+void imhui_mouse_move(ImHui *imhui, float x, float y)
+{
+    imhui->mouse_pos = vec2(x, y);
+}
+
+bool imhui_input_push(ImHui_Input_Queue *queue, ImHui_Input_Event event)
+{
+    const size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    // NOTE: the consumer advances the head before it lets go of the slot, so the head
+    // loaded after taking the slot tells whether the event in it was consumed already.
+    if (event.type == IMHUI_INPUT_MOUSE_MOVE) {
+        const size_t last = (tail - 1) & (IMHUI_INPUT_QUEUE_CAPACITY - 1);
+        if (!atomic_exchange_explicit(&queue->busy[last], true, memory_order_acquire)) {
+            const size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+            const bool merged = head != tail && queue->events[last].type == IMHUI_INPUT_MOUSE_MOVE;
+            if (merged) {
+                queue->events[last] = event;
+            }
+            atomic_store_explicit(&queue->busy[last], false, memory_order_release);
+            if (merged) {
+                return true;
+            }
+        }
+    }
+
+    const size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (tail - head == IMHUI_INPUT_QUEUE_CAPACITY) {
+        return false;
+    }
+
+    queue->events[tail & (IMHUI_INPUT_QUEUE_CAPACITY - 1)] = event;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+bool imhui_input_pending(ImHui_Input_Queue *queue)
+{
+    return atomic_load_explicit(&queue->head, memory_order_relaxed) !=
+           atomic_load_explicit(&queue->tail, memory_order_acquire);
+}
+
+// Applies the queued events in order. The widgets only see the state of the mouse at the
+// beginning of a frame, so a press and a release that arrived within the same frame would
+// never make a click. Hence the draining stops right after a button transition, and the
+// rest of the events (including the moves, so the button is released where it was) stay
+// in the queue until the next frame.
+static void imhui_input_drain(ImHui *imhui)
+{
+    ImHui_Input_Queue *queue = imhui->input;
+    if (queue == NULL) {
+        return;
+    }
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    const size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+    bool transition = false;
+    while (head != tail && !transition) {
+        // NOTE: the producer is merging a move into this slot right now, it is the last one
+        const size_t index = head & (IMHUI_INPUT_QUEUE_CAPACITY - 1);
+        if (atomic_exchange_explicit(&queue->busy[index], true, memory_order_acquire)) {
+            break;
+        }
+        const ImHui_Input_Event event = queue->events[index];
+        head += 1;
+        atomic_store_explicit(&queue->head, head, memory_order_release);
+        atomic_store_explicit(&queue->busy[index], false, memory_order_release);
+
+        transition = event.type == IMHUI_INPUT_MOUSE_DOWN || event.type == IMHUI_INPUT_MOUSE_UP;
+        switch (event.type) {
+        case IMHUI_INPUT_MOUSE_MOVE:
+            imhui_mouse_move(imhui, event.pos.x, event.pos.y);
+            break;
+        case IMHUI_INPUT_MOUSE_DOWN:
+            imhui_mouse_down(imhui);
+            break;
+        case IMHUI_INPUT_MOUSE_UP:
+            imhui_mouse_up(imhui);
+            break;
+        case IMHUI_INPUT_MOUSE_SCROLL:
+            imhui_mouse_scroll(imhui, event.dy);
+            break;
+        default:
+            assert(false && "imhui_input_drain: unknown event type");
+            exit(1);
+        }
+        imhui->input_time = event.time;
+    }
+}
+
+// NOTE: the previous frame is kept for the vertex cache and the dirty check. Swapping
+// keeps the capacities of both of the buffers, so it does not allocate in the steady state.
+static void imhui_swap_output(ImHui *imhui)
+{
+    IMHUI_SWAP(Vertex*, imhui->vertices, imhui->prev_vertices);
+    IMHUI_SWAP(size_t, imhui->vertices_capacity, imhui->prev_vertices_capacity);
+    imhui->prev_vertices_count = imhui->vertices_count;
+
+    IMHUI_SWAP(Triangle*, imhui->triangles, imhui->prev_triangles);
+    IMHUI_SWAP(size_t, imhui->triangles_capacity, imhui->prev_triangles_capacity);
+    imhui->prev_triangles_count = imhui->triangles_count;
+
+    IMHUI_SWAP(Quad*, imhui->quads, imhui->prev_quads);
+    IMHUI_SWAP(size_t, imhui->quads_capacity, imhui->prev_quads_capacity);
+    imhui->prev_quads_count = imhui->quads_count;
+
+    IMHUI_SWAP(ImHui_Batch*, imhui->batches, imhui->prev_batches);
+    IMHUI_SWAP(size_t, imhui->batches_capacity, imhui->prev_batches_capacity);
+    imhui->prev_batches_count = imhui->batches_count;
+}
+
+void imhui_begin(ImHui *imhui, Vec2 start, float padding)
+{
+    imhui->frame += 1;
+    memset(&imhui->stats, 0, sizeof(imhui->stats));
+    imhui_input_drain(imhui);
+
+    imhui_swap_output(imhui);
+
+    IMHUI_SWAP(ImHui_Hit_Rect*, imhui->hit_rects, imhui->prev_hit_rects);
+    IMHUI_SWAP(size_t, imhui->hit_rects_capacity, imhui->prev_hit_rects_capacity);
+    imhui->prev_hit_rects_count = imhui->hit_rects_count;
+
+    IMHUI_SWAP(ImHui_Layout_Tree, imhui->layout, imhui->prev_layout);
+
+    imhui->vertices_count = 0;
+    imhui->triangles_count = 0;
+    imhui->quads_count = 0;
+    imhui->batches_count = 0;
+    imhui->hit_rects_count = 0;
+    imhui->layout.count = 0;
+    imhui_resolve_hot(imhui);
+    imhui_atlas_begin(imhui);
+    imhui_layout_start(imhui, IMHUI_VERT_LAYOUT, start, padding);
+
+    imhui->id_stack_size = 0;
+    imhui->clip_stack_size = 0;
+    if (imhui->width > 0 && imhui->height > 0) {
+        imhui_clip_push(imhui, (ImHui_Clip) {
+            0.0f, 0.0f, (float) imhui->width, (float) imhui->height
+        });
+    } else {
+        imhui_clip_push(imhui, (ImHui_Clip) {
+            -FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX
+        });
+    }
+}
+
+void imhui_text(ImHui *imhui, const char *text)
+{
+    const Vec2 p = imhui_next_widget_position(imhui);
+    const ImHui_Text_Metrics metrics = imhui_measure_text(imhui, text, IMHUI_TEXT_SCALE);
+    imhui_expand_layout(imhui, metrics.size);
+    imhui_render_text_len(imhui, p, IMHUI_TEXT_SCALE, IMHUI_TEXT_COLOR, text, metrics.length);
+}
+
+// Indexes only the bytes appended since the previous update, so it can be called
+// every frame on a growing log. A different buffer or a shorter text rebuilds the index.
+// The text edited in place is not noticed, call imhui_line_index_reset() after such edits.
+void imhui_line_index_update(ImHui *imhui, ImHui_Line_Index *index, const char *data, size_t size)
+{
+    if (index->data != data || size < index->size) {
+        index->data = data;
+        imhui_line_index_reset(index);
+    }
+
+    if (index->lines_count == 0) {
+        index->lines = imhui_reserve(imhui, index->lines, sizeof(*index->lines), &index->lines_capacity, 1);
+        index->lines[index->lines_count++] = 0;
+    }
+
+    if (size == index->size) {
+        return;
+    }
+
+    for (const char *newline = memchr(data + index->size, '\n', size - index->size);
+            newline != NULL;
+            newline = memchr(newline + 1, '\n', size - (newline + 1 - data))) {
+        index->lines = imhui_reserve(imhui, index->lines, sizeof(*index->lines), &index->lines_capacity, index->lines_count + 1);
+        index->lines[index->lines_count++] = newline + 1 - data;
+    }
+    index->size = size;
+}
+
+// Forgets the indexed lines but keeps the memory, the next update indexes the whole text
+void imhui_line_index_reset(ImHui_Line_Index *index)
+{
+    index->size = 0;
+    index->lines_count = 0;
+}
+
+void imhui_line_index_free(ImHui *imhui, ImHui_Line_Index *index)
+{
+    imhui_realloc(imhui, index->lines, index->lines_capacity * sizeof(*index->lines), 0);
+    memset(index, 0, sizeof(*index));
+}
+
+// Only the lines within the view are tessellated, so the cost of a frame does not
+// depend on the size of the text. `scroll` is in pixels and is clamped to the
+// text, set it to INFINITY to follow the tail of a log.
+void imhui_text_view(ImHui *imhui, const ImHui_Line_Index *index, Vec2 size, float *scroll)
+{
+    const Vec2 p = imhui_next_widget_position(imhui);
+    imhui_expand_layout(imhui, size);
+
+    const float line_height = FONT_CHAR_HEIGHT * IMHUI_TEXT_SCALE;
+    // The last column may be partially visible
+    const size_t columns = (size_t) (size.x / (FONT_CHAR_WIDTH * IMHUI_TEXT_SCALE)) + 1;
+
+    // NOTE: the empty line after the final newline is not shown
+    size_t lines_count = index->lines_count;
+    if (lines_count > 1 && index->lines[lines_count - 1] == index->size) {
+        lines_count -= 1;
+    }
+
+    // NOTE: the text view has no ID of its own, the index identifies it within the scope
+    if (imhui_hovered(imhui, imhui_id_index(imhui, (size_t) (uintptr_t) index), p, size)) {
+        *scroll -= imhui->mouse_scroll * line_height * IMHUI_TEXT_VIEW_SCROLL_LINES;
+    }
+    const float max_scroll = lines_count * line_height > size.y ? lines_count * line_height - size.y : 0.0f;
+    *scroll = *scroll > max_scroll ? max_scroll : *scroll;
+    *scroll = *scroll > 0.0f ? *scroll : 0.0f;
+
+    imhui_fill_rect(imhui, p, size, IMHUI_TEXT_VIEW_COLOR);
+
+    imhui_clip_begin(imhui, p, size);
+    for (size_t i = (size_t) (*scroll / line_height); i < lines_count; ++i) {
+        const float y = p.y + i * line_height - *scroll;
+        if (y >= p.y + size.y) {
+            break;
+        }
+
+        const size_t begin = index->lines[i];
+        size_t end = i + 1 < index->lines_count ? index->lines[i + 1] - 1 : index->size;
+        if (end > begin && index->data[end - 1] == '\r') {
+            end -= 1;
+        }
+        size_t visible = columns;
+        const size_t n = imhui_utf8_skip(index->data + begin, end - begin, &visible);
+        imhui_render_run(imhui, vec2(p.x, y), IMHUI_TEXT_SCALE, IMHUI_TEXT_COLOR, index->data + begin, n);
+    }
+    imhui_clip_end(imhui);
+}
+
+// Copies the tessellation recorded in the cache from the previous frame
+// and rebases the triangle indices onto the current vertices.
+static void imhui_copy_prev(ImHui *imhui, ImHui_Button_Cache *cache)
+{
+    assert(cache->vertices_first + cache->vertices_count <= imhui->prev_vertices_count);
+    assert(cache->triangles_first + cache->triangles_count <= imhui->prev_triangles_count);
+    assert(cache->quads_first + cache->quads_count <= imhui->prev_quads_count);
+
+    if (cache->vertices_count > 0) {
+        imhui_reserve_geometry(imhui, cache->vertices_count, cache->triangles_count);
+    }
+    if (cache->quads_count > 0) {
+        imhui_reserve_quads(imhui, cache->quads_count);
+    }
+
+    memcpy(imhui->vertices + imhui->vertices_count,
+           imhui->prev_vertices + cache->vertices_first,
+           cache->vertices_count * sizeof(*imhui->vertices));
+
+    // NOTE: the unsigned arithmetic wraps around, so the delta may be "negative"
+    const size_t index_first = cache->vertices_count > 0 ? imhui->vertices_count - imhui_top_batch(imhui)->base_vertex : 0;
+    const ImHui_Index delta = (ImHui_Index) (index_first - cache->index_first);
+    const Triangle *src = imhui->prev_triangles + cache->triangles_first;
+    Triangle *dst = imhui->triangles + imhui->triangles_count;
+    for (size_t i = 0; i < cache->triangles_count; ++i) {
+        dst[i] = triangle(
+                     (ImHui_Index) (src[i].a + delta),
+                     (ImHui_Index) (src[i].b + delta),
+                     (ImHui_Index) (src[i].c + delta));
+    }
+    cache->index_first = index_first;
+
+    memcpy(imhui->quads + imhui->quads_count,
+           imhui->prev_quads + cache->quads_first,
+           cache->quads_count * sizeof(*imhui->quads));
+
+    cache->vertices_first = imhui->vertices_count;
+    cache->triangles_first = imhui->triangles_count;
+    cache->quads_first = imhui->quads_count;
+    imhui->vertices_count += cache->vertices_count;
+    imhui->triangles_count += cache->triangles_count;
+    imhui->quads_count += cache->quads_count;
+}
+
+bool imhui_button(ImHui *imhui, const char *text, ImHui_ID id)
+{
+    const Vec2 p = imhui_next_widget_position(imhui);
+    const Vec2 s = IMHUI_BUTTON_SIZE;
+    imhui_expand_layout(imhui, s);
+
+    size_t label_length = 0;
+    const uint64_t label_hash = imhui_hash_cstr(text, &label_length);
+    if (id == 0) {
+        id = imhui_id_combine(imhui_top_id(imhui), label_hash);
+    }
+
+    imhui_check_id(imhui, id);
+
+    const ImHui_Clip *clip = imhui_top_clip(imhui);
+    const bool hovered = imhui_hovered(imhui, id, p, s);
+
+    bool clicked = false;
+    ImHui_Button_State state = IMHUI_BUTTON_IDLE;
 
     if (imhui->active != id) {
-        if (imhui_rect_contains(p, s, imhui->mouse_pos)) {
+        if (hovered) {
             if (imhui->mouse_buttons & BUTTON_LEFT) {
                 if (imhui->active == 0) {
                     imhui->active = id;
                 }
             }
-            color = IMHUI_BUTTON_COLOR_HOT;
+            state = IMHUI_BUTTON_HOT;
         }
     } else {
-        color = IMHUI_BUTTON_COLOR_ACTIVE;
-        offset = vec2(0.0f, 0.0f);
+        state = IMHUI_BUTTON_ACTIVE;
         if (!(imhui->mouse_buttons & BUTTON_LEFT)) {
-            if (imhui_rect_contains(p, s, imhui->mouse_pos)) {
+            if (hovered) {
                 clicked = true;
             }
-            // TODO(#8): it's a little bit confusing to use `active == 0` as the indication of no active widget
-            // But using `-1` is actually against the zero initialization rule of the ImHui struct
             imhui->active = 0;
         }
     }
 
+    RGBA color = IMHUI_BUTTON_COLOR;
+    Vec2 offset = IMHUI_BUTTON_OFFSET;
+    switch (state) {
+    case IMHUI_BUTTON_IDLE:
+        break;
+    case IMHUI_BUTTON_HOT:
+        color = IMHUI_BUTTON_COLOR_HOT;
+        break;
+    case IMHUI_BUTTON_ACTIVE:
+        color = IMHUI_BUTTON_COLOR_ACTIVE;
+        offset = vec2(0.0f, 0.0f);
+        break;
+    default:
+        assert(false && "imhui_button: unreachable");
+        exit(1);
+    }
+
+    // NOTE: the label may overflow the button (see #9), so a button is culled only when
+    // both of them are outside of the clip. The label is measured up front only then.
+    const Vec2 top = vec2(p.x - offset.x, p.y - offset.y);
+    ImHui_Text_Metrics label = {0};
+    bool measured = false;
+    if (!imhui_clip_overlaps(clip, top, vec2(p.x + s.x - top.x, p.y + s.y - top.y))) {
+        label = imhui_text_metrics(imhui, text, label_hash, label_length, IMHUI_BUTTON_TEXT_SCALE);
+        measured = true;
+        const Vec2 label_p = vec2(top.x + s.x * 0.5f - label.size.x * 0.5f, top.y + s.y * 0.5f - label.size.y * 0.5f);
+        if (!imhui_clip_overlaps(clip, label_p, label.size)) {
+            return clicked;
+        }
+    }
+
+    // Both of the rects and every glyph of the label, which never has more glyphs than bytes.
+    // Keeping the whole button within a single batch lets the cache rebase its triangles with a single delta.
+    const size_t quads_count = 2 + label_length;
+    const bool single_batch = !imhui->instanced && quads_count * 4 - 1 <= IMHUI_INDEX_MAX;
+
+    ImHui_Button_Cache *cache = NULL;
+    if (imhui->vertex_cache) {
+        cache = imhui_table_insert(imhui, &imhui->button_cache, sizeof(*cache), id);
+
+        if (cache->slot.frame == imhui->frame) {
+            // NOTE: the same ID was already used this frame. Do not let the duplicates fight over the slot.
+            cache = NULL;
+        } else if (!imhui->instanced && !single_batch) {
+            cache = NULL;
+        } else if (cache->slot.frame + 1 == imhui->frame &&
+                   cache->slot.frame != imhui->flex_moved_frame &&
+                   cache->instanced == imhui->instanced &&
+                   cache->label_hash == label_hash &&
+                   cache->position.x == p.x &&
+                   cache->position.y == p.y &&
+                   imhui_same_clip(&cache->clip, clip) &&
+                   cache->state == state) {
+            imhui_copy_prev(imhui, cache);
+            imhui_table_touch(&imhui->button_cache, cache, imhui->frame);
+            imhui->stats.cache_hits += 1;
+            return clicked;
+        } else {
+            cache->label_hash = label_hash;
+            cache->position = p;
+            cache->clip = *clip;
+            cache->state = state;
+            cache->instanced = imhui->instanced;
+            imhui_table_touch(&imhui->button_cache, cache, imhui->frame);
+            imhui->stats.cache_misses += 1;
+        }
+    }
+
+    // NOTE: the cache hits do not need the metrics, the same hash means the same label
+    if (!measured) {
+        label = imhui_text_metrics(imhui, text, label_hash, label_length, IMHUI_BUTTON_TEXT_SCALE);
+    }
+
+    if (single_batch) {
+        imhui_reserve_geometry(imhui, quads_count * 4, quads_count * 2);
+    }
+
+    if (cache) {
+        cache->index_first = single_batch ? imhui->vertices_count - imhui_top_batch(imhui)->base_vertex : 0;
+        cache->vertices_first = imhui->vertices_count;
+        cache->triangles_first = imhui->triangles_count;
+        cache->quads_first = imhui->quads_count;
+    }
+
     imhui_fill_rect(
         imhui,
         vec2(p.x, p.y),
@@ -906,29 +3749,516 @@ bool imhui_button(ImHui *imhui, const char *text, ImHui_ID id)
 
     imhui_fill_rect(
         imhui,
-        vec2(p.x - offset.x, p.y - offset.y),
+        top,
         IMHUI_BUTTON_SIZE,
         color);
 
-    const float text_height = FONT_CHAR_HEIGHT * IMHUI_BUTTON_TEXT_SCALE;
-    const float text_width = FONT_CHAR_WIDTH * IMHUI_BUTTON_TEXT_SCALE * strlen(text);
 
     // TODO(#9): imhui_button does not handle the situation when the text is too big to fit into the boundaries of the button
-    imhui_render_text(
+    imhui_render_text_len(
         imhui,
         vec2(
-            p.x - offset.x + IMHUI_BUTTON_SIZE.x * 0.5f - text_width * 0.5f,
-            p.y - offset.y + IMHUI_BUTTON_SIZE.y * 0.5f - text_height * 0.5f),
+            top.x + IMHUI_BUTTON_SIZE.x * 0.5f - label.size.x * 0.5f,
+            top.y + IMHUI_BUTTON_SIZE.y * 0.5f - label.size.y * 0.5f),
         IMHUI_BUTTON_TEXT_SCALE,
         IMHUI_BUTTON_TEXT_COLOR,
-        text);
+        text,
+        label.length);
+
+    if (cache) {
+        cache->vertices_count = imhui->vertices_count - cache->vertices_first;
+        cache->triangles_count = imhui->triangles_count - cache->triangles_first;
+        cache->quads_count = imhui->quads_count - cache->quads_first;
+    }
 
     return clicked;
 }
 
+// Draws the [uv_p, uv_p + uv_s] part of a texture of the backend
+void imhui_image(ImHui *imhui, ImHui_Texture texture, Vec2 size, Vec2 uv_p, Vec2 uv_s)
+{
+    const Vec2 p = imhui_next_widget_position(imhui);
+    imhui_expand_layout(imhui, size);
+
+    imhui->texture = texture;
+    imhui_fill_rect_uv(imhui, p, size, rgba(1.0f, 1.0f, 1.0f, 1.0f), uv_p, uv_s);
+    imhui->texture = 0;
+}
+
+// Records a call of `callback` between the geometry emitted before and after it.
+// Whatever state the callback changes in the backend it has to restore.
+void imhui_draw_callback(ImHui *imhui, ImHui_Draw_Callback callback, void *user)
+{
+    assert(callback != NULL);
+    imhui_push_batch(imhui);
+    imhui_top_batch(imhui)->callback = callback;
+    imhui_top_batch(imhui)->user = user;
+}
+
+// NOTE: a clean subtree is still rebuilt between IMHUI_STATE_MAX_AGE/2 and IMHUI_STATE_MAX_AGE
+// frames after it was built, so the retained states within it are looked up before they are
+// collected. The age depends on the ID, so the subtrees built together get rebuilt apart.
+static size_t imhui_subtree_max_age(ImHui_ID id)
+{
+    return IMHUI_STATE_MAX_AGE / 2 + imhui_hash_u64(id) % (IMHUI_STATE_MAX_AGE / 2);
+}
+
+// Whether the widget `hot` or `active` recorded any of the `rects`
+static bool imhui_subtree_interacting(const ImHui_Hit_Rect *rects, size_t count, ImHui_ID hot, ImHui_ID active)
+{
+    if (hot == 0 && active == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (rects[i].id != 0 && (rects[i].id == hot || rects[i].id == active)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The first batch of the previous frame that ends after the triangle (or the quad) `first`
+static size_t imhui_prev_batch_at(const ImHui *imhui, size_t first, bool quads)
+{
+    size_t lo = 0;
+    size_t hi = imhui->prev_batches_count;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        const ImHui_Batch *batch = &imhui->prev_batches[mid];
+        const size_t last = quads ? batch->first_quad + batch->quads_count : batch->first_triangle + batch->triangles_count;
+        if (last <= first) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Makes sure the top batch has the state of the batch `prev` of the subtree copied from
+// `cache` to `vertices_first` and can index all of its vertices. The batches that began
+// within the subtree begin at the same vertex of the copy, so the output is the same as
+// if the subtree was built again.
+static void imhui_replay_batch(ImHui *imhui, const ImHui_Batch *prev, const ImHui_Subtree_Cache *cache, size_t vertices_first)
+{
+    const size_t base_vertex = prev->base_vertex > cache->vertices_first
+                               ? vertices_first + (prev->base_vertex - cache->vertices_first)
+                               : vertices_first;
+    if (imhui->batches_count > 0) {
+        const ImHui_Batch *top = imhui_top_batch(imhui);
+        if (top->callback == NULL &&
+                top->texture == prev->texture &&
+                imhui_same_clip(&top->clip, &prev->clip) &&
+                (prev->base_vertex <= cache->vertices_first || top->base_vertex == base_vertex) &&
+                (cache->vertices_count == 0 || vertices_first + cache->vertices_count - 1 - top->base_vertex <= IMHUI_INDEX_MAX)) {
+            return;
+        }
+    }
+
+    imhui->batches = imhui_reserve(
+                         imhui,
+                         imhui->batches,
+                         sizeof(*imhui->batches),
+                         &imhui->batches_capacity,
+                         imhui->batches_count + 1);
+    imhui->batches[imhui->batches_count++] = (ImHui_Batch) {
+        .base_vertex = base_vertex,
+        .first_triangle = imhui->triangles_count,
+        .first_quad = imhui->quads_count,
+        .clip = prev->clip,
+        .texture = prev->texture,
+    };
+}
+
+// Copies the geometry of the subtree from the previous frame. The vertices go as a single
+// block, the triangles and the quads go batch by batch of the previous frame, since they
+// may have been drawn with different clip rects and textures.
+static void imhui_replay_geometry(ImHui *imhui, const ImHui_Subtree_Cache *cache)
+{
+    const size_t vertices_first = imhui->vertices_count;
+    if (cache->vertices_count > 0) {
+        imhui->vertices = imhui_reserve(
+                              imhui,
+                              imhui->vertices,
+                              sizeof(*imhui->vertices),
+                              &imhui->vertices_capacity,
+                              imhui->vertices_count + cache->vertices_count);
+        memcpy(imhui->vertices + imhui->vertices_count,
+               imhui->prev_vertices + cache->vertices_first,
+               cache->vertices_count * sizeof(*imhui->vertices));
+        imhui->vertices_count += cache->vertices_count;
+    }
+
+    const bool quads = cache->instanced;
+    const size_t first = quads ? cache->quads_first : cache->triangles_first;
+    const size_t last = first + (quads ? cache->quads_count : cache->triangles_count);
+    if (first == last) {
+        return;
+    }
+    if (quads) {
+        imhui->quads = imhui_reserve(
+                           imhui,
+                           imhui->quads,
+                           sizeof(*imhui->quads),
+                           &imhui->quads_capacity,
+                           imhui->quads_count + cache->quads_count);
+    } else {
+        imhui->triangles = imhui_reserve(
+                               imhui,
+                               imhui->triangles,
+                               sizeof(*imhui->triangles),
+                               &imhui->triangles_capacity,
+                               imhui->triangles_count + cache->triangles_count);
+    }
+
+    size_t at = first;
+    for (size_t i = imhui_prev_batch_at(imhui, first, quads); at < last; ++i) {
+        assert(i < imhui->prev_batches_count);
+        const ImHui_Batch *batch = &imhui->prev_batches[i];
+        const size_t batch_last = quads ? batch->first_quad + batch->quads_count : batch->first_triangle + batch->triangles_count;
+        const size_t n = (last < batch_last ? last : batch_last) - at;
+        imhui_replay_batch(imhui, batch, cache, vertices_first);
+
+        if (quads) {
+            memcpy(imhui->quads + imhui->quads_count, imhui->prev_quads + at, n * sizeof(*imhui->quads));
+            imhui->quads_count += n;
+        } else {
+            // NOTE: the unsigned arithmetic wraps around, so the delta may be "negative"
+            const ImHui_Index delta = (ImHui_Index) (vertices_first - cache->vertices_first + batch->base_vertex - imhui_top_batch(imhui)->base_vertex);
+            const Triangle *src = imhui->prev_triangles + at;
+            Triangle *dst = imhui->triangles + imhui->triangles_count;
+            for (size_t j = 0; j < n; ++j) {
+                dst[j] = triangle(
+                             (ImHui_Index) (src[j].a + delta),
+                             (ImHui_Index) (src[j].b + delta),
+                             (ImHui_Index) (src[j].c + delta));
+            }
+            imhui->triangles_count += n;
+        }
+        at += n;
+    }
+}
+
+// Copies the clean subtree over from the previous frame and makes its root the top layout
+static void imhui_subtree_replay(ImHui *imhui, const ImHui_Subtree_Cache *cache)
+{
+    ImHui_Layout_Tree *tree = &imhui->layout;
+    const ImHui_Layout_Tree *prev = &imhui->prev_layout;
+    imhui_layout_tree_reserve(imhui, tree, tree->count + cache->nodes_count);
+
+    // The links are shifted to the new nodes. NOTE: the unsigned arithmetic wraps around
+    // as well, IMHUI_LAYOUT_NONE stays as it is.
+    const size_t node = tree->count;
+    const size_t nodes_delta = node - cache->nodes_first;
+    const size_t m = cache->nodes_count;
+    memcpy(tree->type + node, prev->type + cache->nodes_first, m * sizeof(*tree->type));
+    memcpy(tree->start + node, prev->start + cache->nodes_first, m * sizeof(*tree->start));
+    memcpy(tree->size + node, prev->size + cache->nodes_first, m * sizeof(*tree->size));
+    memcpy(tree->padding + node, prev->padding + cache->nodes_first, m * sizeof(*tree->padding));
+    memcpy(tree->subtree + node, prev->subtree + cache->nodes_first, m * sizeof(*tree->subtree));
+    memcpy(tree->flex + node, prev->flex + cache->nodes_first, m * sizeof(*tree->flex));
+    for (size_t i = 0; i < m; ++i) {
+        const size_t j = cache->nodes_first + i;
+        tree->parent[node + i] = prev->parent[j] == IMHUI_LAYOUT_NONE ? IMHUI_LAYOUT_NONE : prev->parent[j] + nodes_delta;
+        tree->first_child[node + i] = prev->first_child[j] == IMHUI_LAYOUT_NONE ? IMHUI_LAYOUT_NONE : prev->first_child[j] + nodes_delta;
+        tree->next_sibling[node + i] = prev->next_sibling[j] == IMHUI_LAYOUT_NONE ? IMHUI_LAYOUT_NONE : prev->next_sibling[j] + nodes_delta;
+    }
+    tree->count += m;
+    imhui_layout_push(imhui, node);
+
+    // The subtrees nested in it were copied along with it, so their recordings move too
+    const size_t vertices_delta = imhui->vertices_count - cache->vertices_first;
+    const size_t triangles_delta = imhui->triangles_count - cache->triangles_first;
+    const size_t quads_delta = imhui->quads_count - cache->quads_first;
+    const size_t hit_rects_delta = imhui->hit_rects_count - cache->hit_rects_first;
+    for (size_t i = node + 1; i < tree->count; ++i) {
+        if (tree->subtree[i] == 0) {
+            continue;
+        }
+        ImHui_Subtree_Cache *nested = imhui_table_insert(imhui, &imhui->subtree_cache, sizeof(*nested), tree->subtree[i]);
+        if (nested->slot.frame + 1 == imhui->frame) {
+            nested->nodes_first += nodes_delta;
+            nested->vertices_first += vertices_delta;
+            nested->triangles_first += triangles_delta;
+            nested->quads_first += quads_delta;
+            nested->hit_rects_first += hit_rects_delta;
+            imhui_table_touch(&imhui->subtree_cache, nested, imhui->frame);
+        }
+    }
+
+    imhui_replay_geometry(imhui, cache);
+
+    if (cache->hit_rects_count > 0) {
+        imhui->hit_rects = imhui_reserve(
+                               imhui,
+                               imhui->hit_rects,
+                               sizeof(*imhui->hit_rects),
+                               &imhui->hit_rects_capacity,
+                               imhui->hit_rects_count + cache->hit_rects_count);
+        memcpy(imhui->hit_rects + imhui->hit_rects_count,
+               imhui->prev_hit_rects + cache->hit_rects_first,
+               cache->hit_rects_count * sizeof(*imhui->hit_rects));
+        imhui->hit_rects_count += cache->hit_rects_count;
+    }
+}
+
+bool imhui_subtree_begin(ImHui *imhui, ImHui_ID id, ImHui_Layout_Type type, float padding, uint64_t version)
+{
+    assert(id != 0 && "imhui_subtree_begin: the subtree needs an ID");
+    const Vec2 start = imhui_next_widget_position(imhui);
+
+    imhui->subtree_stack = imhui_reserve(
+                               imhui,
+                               imhui->subtree_stack,
+                               sizeof(*imhui->subtree_stack),
+                               &imhui->subtree_stack_capacity,
+                               imhui->subtree_stack_size + 1);
+    ImHui_Subtree *subtree = &imhui->subtree_stack[imhui->subtree_stack_size++];
+    *subtree = (ImHui_Subtree) {
+        .id = id,
+        .version = version,
+        .active = imhui->active,
+        .node = imhui->layout.count,
+        .batches_first = imhui->batches_count,
+        .base_vertex = imhui->batches_count > 0 ? imhui_top_batch(imhui)->base_vertex : imhui->vertices_count,
+        .vertices_first = imhui->vertices_count,
+        .triangles_first = imhui->triangles_count,
+        .quads_first = imhui->quads_count,
+        .hit_rects_first = imhui->hit_rects_count,
+    };
+
+    const ImHui_Subtree_Cache *cache = imhui_table_insert(imhui, &imhui->subtree_cache, sizeof(*cache), id);
+    subtree->reused =
+        cache->slot.frame + 1 == imhui->frame &&
+        cache->slot.frame != imhui->flex_moved_frame &&
+        cache->reusable &&
+        cache->version == version &&
+        cache->type == type &&
+        cache->padding == padding &&
+        cache->start.x == start.x &&
+        cache->start.y == start.y &&
+        imhui_same_clip(&cache->clip, imhui_top_clip(imhui)) &&
+        cache->instanced == imhui->instanced &&
+        (cache->vertices_count == 0 || imhui->vertices_count + cache->vertices_count - 1 - subtree->base_vertex <= IMHUI_INDEX_MAX) &&
+        imhui->frame - cache->built < imhui_subtree_max_age(id) &&
+        !imhui->active_hidden &&
+        !imhui_subtree_interacting(imhui->prev_hit_rects + cache->hit_rects_first, cache->hit_rects_count, imhui->hot, imhui->active);
+
+    if (!subtree->reused) {
+        const size_t node = imhui_layout_start(imhui, type, start, padding);
+        imhui->layout.subtree[node] = id;
+        imhui->stats.subtrees_built += 1;
+        return true;
+    }
+
+    // NOTE: the lookups of the nested subtrees may move the slots of the table
+    const ImHui_Subtree_Cache recorded = *cache;
+    imhui_subtree_replay(imhui, &recorded);
+    imhui->stats.subtrees_reused += 1;
+    return false;
+}
+
+void imhui_subtree_end(ImHui *imhui)
+{
+    assert(imhui->subtree_stack_size > 0 && "imhui_subtree_end: no matching imhui_subtree_begin()");
+    const ImHui_Subtree subtree = imhui->subtree_stack[--imhui->subtree_stack_size];
+    assert(imhui_top_layout(imhui) == subtree.node && "imhui_subtree_end: the layouts within the subtree are not balanced");
+
+    ImHui_Subtree_Cache *cache = imhui_table_insert(imhui, &imhui->subtree_cache, sizeof(*cache), subtree.id);
+    if (subtree.reused) {
+        assert(imhui->layout.count == subtree.node + cache->nodes_count &&
+               imhui->hit_rects_count == subtree.hit_rects_first + cache->hit_rects_count &&
+               "imhui_subtree_end: the content of a clean subtree must be skipped");
+    } else {
+        // NOTE: the subtree that overflowed the indices of the batch it began in was split
+        // where it happened to overflow, which is not where it would overflow elsewhere.
+        // The one that fits and is copied where it still fits is never split at all.
+        const size_t vertices_count = imhui->vertices_count - subtree.vertices_first;
+        bool reusable = vertices_count == 0 || imhui->vertices_count - 1 - subtree.base_vertex <= IMHUI_INDEX_MAX;
+        for (size_t i = subtree.batches_first; i < imhui->batches_count; ++i) {
+            reusable = reusable && imhui->batches[i].callback == NULL;
+        }
+
+        // NOTE: the subtree that shows a hot or an active widget has to be rebuilt once it is not
+        // anymore. The widget released within the subtree was still drawn as the active one.
+        const size_t hit_rects_count = imhui->hit_rects_count - subtree.hit_rects_first;
+        const ImHui_Hit_Rect *rects = imhui->hit_rects + subtree.hit_rects_first;
+        reusable = reusable &&
+                   !imhui_subtree_interacting(rects, hit_rects_count, imhui->hot, imhui->active) &&
+                   !imhui_subtree_interacting(rects, hit_rects_count, 0, subtree.active);
+
+        cache->version = subtree.version;
+        cache->type = imhui->layout.type[subtree.node];
+        cache->padding = imhui->layout.padding[subtree.node];
+        cache->start = imhui->layout.start[subtree.node];
+        cache->clip = *imhui_top_clip(imhui);
+        cache->instanced = imhui->instanced;
+        cache->reusable = reusable;
+        cache->built = imhui->frame;
+        cache->vertices_count = vertices_count;
+        cache->triangles_count = imhui->triangles_count - subtree.triangles_first;
+        cache->quads_count = imhui->quads_count - subtree.quads_first;
+        cache->hit_rects_count = hit_rects_count;
+        cache->nodes_count = imhui->layout.count - subtree.node;
+    }
+    cache->nodes_first = subtree.node;
+    cache->vertices_first = subtree.vertices_first;
+    cache->triangles_first = subtree.triangles_first;
+    cache->quads_first = subtree.quads_first;
+    cache->hit_rects_first = subtree.hit_rects_first;
+    imhui_table_touch(&imhui->subtree_cache, cache, imhui->frame);
+
+    imhui_layout_end(imhui);
+}
+
+// Finishes the counts of the batches, drops the empty ones and merges the
+// adjacent ones with the same state whenever their indices allow it.
+static void imhui_finish_batches(ImHui *imhui, bool *callbacks)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < imhui->batches_count; ++i) {
+        ImHui_Batch batch = imhui->batches[i];
+        const ImHui_Batch *next = i + 1 < imhui->batches_count ? &imhui->batches[i + 1] : NULL;
+        batch.triangles_count = (next ? next->first_triangle : imhui->triangles_count) - batch.first_triangle;
+        batch.quads_count = (next ? next->first_quad : imhui->quads_count) - batch.first_quad;
+
+        if (batch.callback == NULL && batch.triangles_count == 0 && batch.quads_count == 0) {
+            continue;
+        }
+        *callbacks = *callbacks || batch.callback != NULL;
+
+        if (count > 0) {
+            ImHui_Batch *prev = &imhui->batches[count - 1];
+            if (prev->callback == NULL && batch.callback == NULL &&
+                    prev->texture == batch.texture &&
+                    imhui_same_clip(&prev->clip, &batch.clip) &&
+                    (batch.triangles_count == 0 || prev->base_vertex == batch.base_vertex)) {
+                prev->triangles_count += batch.triangles_count;
+                prev->quads_count += batch.quads_count;
+                continue;
+            }
+        }
+
+        imhui->batches[count++] = batch;
+    }
+    imhui->batches_count = count;
+}
+
+static bool imhui_same_items(const void *a, size_t a_count, const void *b, size_t b_count, size_t item_size)
+{
+    return a_count == b_count && (a_count == 0 || memcmp(a, b, a_count * item_size) == 0);
+}
+
+// NOTE: comparing against the previous frame is exact and runs at memcmp() speed,
+// which is considerably cheaper than hashing the streams.
+static bool imhui_same_output(const ImHui *imhui)
+{
+    return
+        imhui_same_items(imhui->vertices, imhui->vertices_count,
+                         imhui->prev_vertices, imhui->prev_vertices_count,
+                         sizeof(*imhui->vertices)) &&
+        imhui_same_items(imhui->triangles, imhui->triangles_count,
+                         imhui->prev_triangles, imhui->prev_triangles_count,
+                         sizeof(*imhui->triangles)) &&
+        imhui_same_items(imhui->quads, imhui->quads_count,
+                         imhui->prev_quads, imhui->prev_quads_count,
+                         sizeof(*imhui->quads)) &&
+        imhui_same_items(imhui->batches, imhui->batches_count,
+                         imhui->prev_batches, imhui->prev_batches_count,
+                         sizeof(*imhui->batches));
+}
+
 void imhui_end(ImHui *imhui)
 {
+    assert(imhui->flex_stack_size == 0 && "imhui_end: no matching imhui_flex_end()");
+    assert(imhui->subtree_stack_size == 0 && "imhui_end: no matching imhui_subtree_end()");
     imhui_layout_end(imhui);
+    imhui->mouse_scroll = 0.0f;
+
+    bool callbacks = false;
+    imhui_finish_batches(imhui, &callbacks);
+
+    // NOTE: only the buttons recorded this frame can be reused on the next one
+    imhui_table_sweep(&imhui->button_cache, imhui->frame);
+    imhui_table_sweep(&imhui->id_table, imhui->frame);
+    imhui_table_sweep(&imhui->flex_cache, imhui->frame);
+    imhui_table_sweep(&imhui->subtree_cache, imhui->frame);
+    imhui_table_sweep(&imhui->text_cache,
+                      imhui->frame > IMHUI_TEXT_CACHE_MAX_AGE ? imhui->frame - IMHUI_TEXT_CACHE_MAX_AGE : 0);
+    imhui_state_collect(imhui);
+
+    imhui->dirty =
+        imhui->frame == 1 ||
+        callbacks ||
+        !imhui_same_output(imhui);
+}
+
+void imhui_merge(ImHui *dst, ImHui *const *contexts, size_t count)
+{
+    size_t vertices_count = 0;
+    size_t triangles_count = 0;
+    size_t quads_count = 0;
+    size_t batches_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        assert(contexts[i] != dst && "imhui_merge: the destination can not be one of the contexts");
+        assert(contexts[i]->instanced == contexts[0]->instanced &&
+               "imhui_merge: all of the contexts must be in the same mode");
+        assert(!contexts[i]->atlas.active && "imhui_merge: every atlas is a separate texture 0");
+        assert(contexts[i]->sdf == contexts[0]->sdf && "imhui_merge: all of the contexts must use the same font");
+        vertices_count += contexts[i]->vertices_count;
+        triangles_count += contexts[i]->triangles_count;
+        quads_count += contexts[i]->quads_count;
+        batches_count += contexts[i]->batches_count;
+    }
+
+    dst->frame += 1;
+    dst->instanced = count > 0 && contexts[0]->instanced;
+    imhui_swap_output(dst);
+    dst->vertices = imhui_reserve(dst, dst->vertices, sizeof(*dst->vertices),
+                                  &dst->vertices_capacity, vertices_count);
+    dst->triangles = imhui_reserve(dst, dst->triangles, sizeof(*dst->triangles),
+                                   &dst->triangles_capacity, triangles_count);
+    dst->quads = imhui_reserve(dst, dst->quads, sizeof(*dst->quads),
+                               &dst->quads_capacity, quads_count);
+    dst->batches = imhui_reserve(dst, dst->batches, sizeof(*dst->batches),
+                                 &dst->batches_capacity, batches_count);
+    dst->vertices_count = 0;
+    dst->triangles_count = 0;
+    dst->quads_count = 0;
+    dst->batches_count = 0;
+
+    // NOTE: the triangles are relative to the base vertex of their batch, so they are
+    // copied as they are. Only the offsets of the batches have to be shifted.
+    for (size_t i = 0; i < count; ++i) {
+        const ImHui *src = contexts[i];
+        if (src->vertices_count > 0) {
+            memcpy(dst->vertices + dst->vertices_count, src->vertices, src->vertices_count * sizeof(*src->vertices));
+        }
+        if (src->triangles_count > 0) {
+            memcpy(dst->triangles + dst->triangles_count, src->triangles, src->triangles_count * sizeof(*src->triangles));
+        }
+        if (src->quads_count > 0) {
+            memcpy(dst->quads + dst->quads_count, src->quads, src->quads_count * sizeof(*src->quads));
+        }
+        for (size_t j = 0; j < src->batches_count; ++j) {
+            ImHui_Batch batch = src->batches[j];
+            batch.base_vertex += dst->vertices_count;
+            batch.first_triangle += dst->triangles_count;
+            batch.first_quad += dst->quads_count;
+            dst->batches[dst->batches_count++] = batch;
+        }
+        dst->vertices_count += src->vertices_count;
+        dst->triangles_count += src->triangles_count;
+        dst->quads_count += src->quads_count;
+    }
+
+    // NOTE: the merged output is compared as a whole, it changes even when none of the
+    // contexts did if they were reordered, replaced, or not merged on some frame.
+    bool callbacks = false;
+    for (size_t i = 0; i < dst->batches_count; ++i) {
+        callbacks = callbacks || dst->batches[i].callback != NULL;
+    }
+    dst->dirty = dst->frame == 1 || callbacks || !imhui_same_output(dst);
 }
 
 #endif // IMHUI_IMPLEMENTATION
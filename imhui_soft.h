@@ -0,0 +1,896 @@
+#ifndef IMHUI_SOFT_H_
+#define IMHUI_SOFT_H_
+
+// Software rasterizer backend for ImHui. Renders the output of a frame into
+// an RGBA8 framebuffer without any GPU, the same way the OpenGL backend of
+// main.c does: nearest sampling of FONT (or of the glyph atlas when it is active),
+// SRC_ALPHA/ONE_MINUS_SRC_ALPHA blending.
+// The textures of imhui_image() are pointers to ImHui_Soft_Image.
+//
+// Include "imhui.h" first and #define IMHUI_SOFT_IMPLEMENTATION in exactly one
+// translation unit. The parallel mode uses pthreads.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define IMHUI_SOFT_TILE_SIZE 64
+#define IMHUI_SOFT_MAX_THREADS 64
+
+typedef struct {
+    uint32_t index;
+    uint32_t base_vertex;
+    uint32_t batch;
+} ImHui_Soft_Bin_Entry;
+
+typedef struct {
+    const uint32_t *pixels;     // RGBA8, the same layout as ImHui_Soft
+    size_t width, height;
+} ImHui_Soft_Image;
+
+// NOTE: zero initialized ImHui_Soft with the `pixels`, `width` and `height`
+// provided by the caller is a valid rasterizer.
+typedef struct {
+    // width * height pixels, 4 bytes each in the R, G, B, A memory order.
+    uint32_t *pixels;
+    size_t width, height;
+
+    // 0 or 1 rasterizes on the calling thread. Otherwise the frame is binned
+    // into IMHUI_SOFT_TILE_SIZE tiles rasterized by that many threads in parallel.
+    size_t threads;
+
+    size_t *bin_offsets;
+    size_t bin_offsets_capacity;
+
+    ImHui_Soft_Bin_Entry *bin_entries;
+    size_t bin_entries_capacity;
+
+    // The coverage of the texture 0 of the frame being rendered, or the distances
+    // of the SDF font when `font_spread` is not 0.
+    const uint8_t *font;
+    int font_width, font_height;
+    float font_spread;
+} ImHui_Soft;
+
+void imhui_soft_free(ImHui_Soft *soft);
+
+void imhui_soft_clear(ImHui_Soft *soft, RGBA color);
+void imhui_soft_render(ImHui_Soft *soft, const ImHui *imhui);
+
+bool imhui_soft_save_ppm(const ImHui_Soft *soft, const char *file_path);
+bool imhui_soft_save_png(const ImHui_Soft *soft, const char *file_path);
+
+#endif // IMHUI_SOFT_H_
+
+#ifdef IMHUI_SOFT_IMPLEMENTATION
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+// A color prepared for blending: out = (src * a + dst * (255 - a)) / 255 for
+// each of the 4 channels, exactly like GL_SRC_ALPHA/GL_ONE_MINUS_SRC_ALPHA.
+typedef struct {
+    uint8_t bytes[4];
+    uint16_t src[4];            // src * a + 128, the rounding bias of the division
+    uint16_t inv_alpha;         // 255 - a
+} ImHui_Soft_Color;
+
+typedef struct {
+    int x0, y0, x1, y1;
+} ImHui_Soft_Clip;
+
+static ImHui_Soft_Color imhui_soft_color(const uint8_t bytes[4])
+{
+    ImHui_Soft_Color color;
+    memcpy(color.bytes, bytes, 4);
+    for (size_t i = 0; i < 4; ++i) {
+        color.src[i] = (uint16_t) (bytes[i] * bytes[3] + 128);
+    }
+    color.inv_alpha = (uint16_t) (255 - bytes[3]);
+    return color;
+}
+
+static uint8_t imhui_soft_unorm8(float x)
+{
+    x = x < 0.0f ? 0.0f : x;
+    x = x > 1.0f ? 1.0f : x;
+    return (uint8_t) (int32_t) (x * 255.0f + 0.5f);
+}
+
+static void imhui_soft_blend_pixel(uint8_t *dst, const ImHui_Soft_Color *color)
+{
+    for (size_t i = 0; i < 4; ++i) {
+        const unsigned int t = dst[i] * color->inv_alpha + color->src[i];
+        dst[i] = (uint8_t) ((t + (t >> 8)) >> 8);
+    }
+}
+
+// Blends a constant color over the pixels [x0, x1) of a row.
+static void imhui_soft_fill_span(uint32_t *row, int x0, int x1, const ImHui_Soft_Color *color)
+{
+    int x = x0;
+
+    if (color->inv_alpha == 0) {
+        uint32_t packed;
+        memcpy(&packed, color->bytes, 4);
+#ifdef __SSE2__
+        const __m128i packed4 = _mm_set1_epi32((int) packed);
+        for (; x + 4 <= x1; x += 4) {
+            _mm_storeu_si128((__m128i*) (row + x), packed4);
+        }
+#endif // __SSE2__
+        for (; x < x1; ++x) {
+            row[x] = packed;
+        }
+        return;
+    }
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i inv_alpha = _mm_set1_epi16((short) color->inv_alpha);
+    const __m128i src = _mm_setr_epi16(
+                            (short) color->src[0], (short) color->src[1], (short) color->src[2], (short) color->src[3],
+                            (short) color->src[0], (short) color->src[1], (short) color->src[2], (short) color->src[3]);
+    for (; x + 4 <= x1; x += 4) {
+        const __m128i dst = _mm_loadu_si128((const __m128i*) (row + x));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), inv_alpha), src);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), inv_alpha), src);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128((__m128i*) (row + x), _mm_packus_epi16(lo, hi));
+    }
+#endif // __SSE2__
+    for (; x < x1; ++x) {
+        imhui_soft_blend_pixel((uint8_t*) (row + x), color);
+    }
+}
+
+// The coverage of the pixel that is `texels` texels wide at (u, v) of the SDF font.
+// The distance is sampled bilinearly and the outline is antialiased over one pixel.
+static int imhui_soft_distance_texel(const ImHui_Soft *soft, float u, float v, float texels)
+{
+    const float x = u * (float) soft->font_width - 0.5f;
+    const float y = v * (float) soft->font_height - 0.5f;
+    const float fx = floorf(x);
+    const float fy = floorf(y);
+    const float ax = x - fx;
+    const float ay = y - fy;
+
+    float d[2][2];
+    for (int j = 0; j < 2; ++j) {
+        for (int i = 0; i < 2; ++i) {
+            int tx = (int) fx + i;
+            int ty = (int) fy + j;
+            tx = tx < 0 ? 0 : tx >= soft->font_width ? soft->font_width - 1 : tx;
+            ty = ty < 0 ? 0 : ty >= soft->font_height ? soft->font_height - 1 : ty;
+            d[j][i] = (float) soft->font[ty * soft->font_width + tx];
+        }
+    }
+    const float distance = (d[0][0] * (1.0f - ax) + d[0][1] * ax) * (1.0f - ay) +
+                           (d[1][0] * (1.0f - ax) + d[1][1] * ax) * ay;
+
+    const float pixels = (distance / 255.0f - 0.5f) * 2.0f * soft->font_spread / fmaxf(texels, 1e-6f);
+    const float coverage = pixels + 0.5f;
+    return coverage <= 0.0f ? 0 : coverage >= 1.0f ? 0xFF : (int) (coverage * 255.0f + 0.5f);
+}
+
+// `texels` is the width of the pixel in the texels, which only matters for the SDF font
+static int imhui_soft_texel(const ImHui_Soft *soft, float u, float v, float texels)
+{
+    if (soft->font_spread > 0.0f) {
+        return imhui_soft_distance_texel(soft, u, v, texels);
+    }
+
+    int tx = (int) floorf(u * (float) soft->font_width);
+    int ty = (int) floorf(v * (float) soft->font_height);
+    tx = tx < 0 ? 0 : tx >= soft->font_width ? soft->font_width - 1 : tx;
+    ty = ty < 0 ? 0 : ty >= soft->font_height ? soft->font_height - 1 : ty;
+    return soft->font[ty * soft->font_width + tx];
+}
+
+// The color of the texture 0, (1, 1, 1, coverage) * color
+static void imhui_soft_blend_coverage(uint8_t *dst, const ImHui_Soft_Color *color, int coverage)
+{
+    if (coverage == 0xFF) {
+        imhui_soft_blend_pixel(dst, color);
+    } else if (coverage > 0) {
+        uint8_t bytes[4];
+        memcpy(bytes, color->bytes, 4);
+        bytes[3] = (uint8_t) ((bytes[3] * coverage + 127) / 255);
+        const ImHui_Soft_Color covered = imhui_soft_color(bytes);
+        imhui_soft_blend_pixel(dst, &covered);
+    }
+}
+
+// texture(image, uv) * color with the nearest sampling
+static ImHui_Soft_Color imhui_soft_image_color(const ImHui_Soft_Image *image, float u, float v, const uint8_t color[4])
+{
+    int tx = (int) floorf(u * (float) image->width);
+    int ty = (int) floorf(v * (float) image->height);
+    tx = tx < 0 ? 0 : tx >= (int) image->width ? (int) image->width - 1 : tx;
+    ty = ty < 0 ? 0 : ty >= (int) image->height ? (int) image->height - 1 : ty;
+
+    uint8_t texel[4];
+    memcpy(texel, &image->pixels[(size_t) ty * image->width + tx], 4);
+    uint8_t bytes[4];
+    for (size_t i = 0; i < 4; ++i) {
+        bytes[i] = (uint8_t) ((texel[i] * color[i] + 127) / 255);
+    }
+    return imhui_soft_color(bytes);
+}
+
+// NOTE: the texels of 0xFF leave the color untouched. The rectangles are drawn with
+// the solid cell of the texture 0, which is checked once per primitive, so that most
+// of the pixels go through imhui_soft_fill_span() without sampling anything.
+static bool imhui_soft_solid_uv(const ImHui_Soft *soft, float u0, float v0, float u1, float v1)
+{
+    const int tx0 = (int) floorf(u0 * (float) soft->font_width);
+    const int ty0 = (int) floorf(v0 * (float) soft->font_height);
+    const int tx1 = (int) ceilf(u1 * (float) soft->font_width);
+    const int ty1 = (int) ceilf(v1 * (float) soft->font_height);
+    if (tx0 < 0 || ty0 < 0 || tx1 > soft->font_width || ty1 > soft->font_height) {
+        return false;
+    }
+
+    for (int ty = ty0; ty < ty1; ++ty) {
+        for (int tx = tx0; tx < tx1; ++tx) {
+            if (soft->font[ty * soft->font_width + tx] != 0xFF) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void imhui_soft_vertex(const Vertex *v, float position[2], float attribs[6])
+{
+#ifdef IMHUI_PACKED_VERTICES
+    position[0] = v->position[0];
+    position[1] = v->position[1];
+    for (size_t i = 0; i < 4; ++i) {
+        attribs[i] = (float) v->color[i] / 255.0f;
+    }
+    attribs[4] = (float) v->uv[0] / 65535.0f;
+    attribs[5] = (float) v->uv[1] / 65535.0f;
+#else
+    position[0] = v->position.x;
+    position[1] = v->position.y;
+    attribs[0] = v->color.r;
+    attribs[1] = v->color.g;
+    attribs[2] = v->color.b;
+    attribs[3] = v->color.a;
+    attribs[4] = v->uv.x;
+    attribs[5] = v->uv.y;
+#endif // IMHUI_PACKED_VERTICES
+}
+
+// Pixel centers are at +0.5. A pixel is covered when its center is within
+// [left, right) x [top, bottom) of the primitive, so the rectangles split into
+// two triangles do not blend their shared diagonal twice.
+static void imhui_soft_triangle(ImHui_Soft *soft, const Vertex *vs[3], const ImHui_Soft_Image *image, ImHui_Soft_Clip clip)
+{
+    float p[3][2];
+    float a[3][6];
+    for (size_t i = 0; i < 3; ++i) {
+        imhui_soft_vertex(vs[i], p[i], a[i]);
+    }
+
+    const float area = (p[1][0] - p[0][0]) * (p[2][1] - p[0][1]) - (p[2][0] - p[0][0]) * (p[1][1] - p[0][1]);
+    if (area == 0.0f) {
+        return;
+    }
+
+    // Plane equations of the attributes: a(x, y) = a0 + dx * (x - x0) + dy * (y - y0)
+    float dx[6], dy[6];
+    for (size_t i = 0; i < 6; ++i) {
+        const float d1 = a[1][i] - a[0][i];
+        const float d2 = a[2][i] - a[0][i];
+        dx[i] = (d1 * (p[2][1] - p[0][1]) - d2 * (p[1][1] - p[0][1])) / area;
+        dy[i] = (d2 * (p[1][0] - p[0][0]) - d1 * (p[2][0] - p[0][0])) / area;
+    }
+
+    const bool flat = memcmp(a[0], a[1], sizeof(float) * 4) == 0 && memcmp(a[0], a[2], sizeof(float) * 4) == 0;
+
+    float min_x = p[0][0], max_x = p[0][0], min_y = p[0][1], max_y = p[0][1];
+    float min_u = a[0][4], max_u = a[0][4], min_v = a[0][5], max_v = a[0][5];
+    for (size_t i = 1; i < 3; ++i) {
+        min_x = fminf(min_x, p[i][0]);
+        max_x = fmaxf(max_x, p[i][0]);
+        min_y = fminf(min_y, p[i][1]);
+        max_y = fmaxf(max_y, p[i][1]);
+        min_u = fminf(min_u, a[i][4]);
+        max_u = fmaxf(max_u, a[i][4]);
+        min_v = fminf(min_v, a[i][5]);
+        max_v = fmaxf(max_v, a[i][5]);
+    }
+    const bool solid = image == NULL && imhui_soft_solid_uv(soft, min_u, min_v, max_u, max_v);
+    const float texels = fmaxf(fabsf(dx[4]) * (float) soft->font_width, fabsf(dy[5]) * (float) soft->font_height);
+
+    uint8_t bytes[4];
+    for (size_t i = 0; i < 4; ++i) {
+        bytes[i] = imhui_soft_unorm8(a[0][i]);
+    }
+    const ImHui_Soft_Color flat_color = imhui_soft_color(bytes);
+
+    // The edges are always walked from the top vertex to the bottom one, so
+    // the triangles sharing an edge compute exactly the same intersections.
+    float edges[3][4];
+    size_t edges_count = 0;
+    for (size_t i = 0; i < 3; ++i) {
+        const float *e0 = p[i];
+        const float *e1 = p[(i + 1) % 3];
+        if (e0[1] == e1[1]) {
+            continue;
+        }
+        if (e0[1] > e1[1]) {
+            const float *t = e0;
+            e0 = e1;
+            e1 = t;
+        }
+        edges[edges_count][0] = e0[0];
+        edges[edges_count][1] = e0[1];
+        edges[edges_count][2] = e1[1];
+        edges[edges_count][3] = (e1[0] - e0[0]) / (e1[1] - e0[1]);
+        edges_count += 1;
+    }
+
+    int y0 = (int) ceilf(min_y - 0.5f);
+    int y1 = (int) ceilf(max_y - 0.5f);
+    y0 = y0 < clip.y0 ? clip.y0 : y0;
+    y1 = y1 > clip.y1 ? clip.y1 : y1;
+
+    for (int y = y0; y < y1; ++y) {
+        const float cy = (float) y + 0.5f;
+
+        float left = max_x, right = min_x;
+        for (size_t i = 0; i < edges_count; ++i) {
+            if (edges[i][1] <= cy && cy < edges[i][2]) {
+                const float x = edges[i][0] + (cy - edges[i][1]) * edges[i][3];
+                left = fminf(left, x);
+                right = fmaxf(right, x);
+            }
+        }
+
+        int x0 = (int) ceilf(left - 0.5f);
+        int x1 = (int) ceilf(right - 0.5f);
+        x0 = x0 < clip.x0 ? clip.x0 : x0;
+        x1 = x1 > clip.x1 ? clip.x1 : x1;
+        if (x0 >= x1) {
+            continue;
+        }
+
+        uint32_t *row = soft->pixels + (size_t) y * soft->width;
+        if (solid && flat) {
+            imhui_soft_fill_span(row, x0, x1, &flat_color);
+            continue;
+        }
+
+        float at[6];
+        const float cx = (float) x0 + 0.5f;
+        for (size_t i = 0; i < 6; ++i) {
+            at[i] = a[0][i] + dx[i] * (cx - p[0][0]) + dy[i] * (cy - p[0][1]);
+        }
+
+        for (int x = x0; x < x1; ++x) {
+            if (image != NULL) {
+                for (size_t i = 0; i < 4; ++i) {
+                    bytes[i] = flat ? flat_color.bytes[i] : imhui_soft_unorm8(at[i]);
+                }
+                const ImHui_Soft_Color color = imhui_soft_image_color(image, at[4], at[5], bytes);
+                imhui_soft_blend_pixel((uint8_t*) (row + x), &color);
+            } else {
+                const int coverage = solid ? 0xFF : imhui_soft_texel(soft, at[4], at[5], texels);
+                if (flat) {
+                    imhui_soft_blend_coverage((uint8_t*) (row + x), &flat_color, coverage);
+                } else if (coverage > 0) {
+                    for (size_t i = 0; i < 4; ++i) {
+                        bytes[i] = imhui_soft_unorm8(at[i]);
+                    }
+                    const ImHui_Soft_Color color = imhui_soft_color(bytes);
+                    imhui_soft_blend_coverage((uint8_t*) (row + x), &color, coverage);
+                }
+            }
+            for (size_t i = 0; i < 6; ++i) {
+                at[i] += dx[i];
+            }
+        }
+    }
+}
+
+static void imhui_soft_quad(ImHui_Soft *soft, const Quad *quad, const ImHui_Soft_Image *image, ImHui_Soft_Clip clip)
+{
+    const int w = quad->rect[2];
+    const int h = quad->rect[3];
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    int x0 = quad->rect[0];
+    int y0 = quad->rect[1];
+    int x1 = x0 + w;
+    int y1 = y0 + h;
+    x0 = x0 < clip.x0 ? clip.x0 : x0;
+    y0 = y0 < clip.y0 ? clip.y0 : y0;
+    x1 = x1 > clip.x1 ? clip.x1 : x1;
+    y1 = y1 > clip.y1 ? clip.y1 : y1;
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    const float uv_x = (float) quad->uv[0] / 65535.0f;
+    const float uv_y = (float) quad->uv[1] / 65535.0f;
+    const float uv_w = (float) quad->uv[2] / 65535.0f;
+    const float uv_h = (float) quad->uv[3] / 65535.0f;
+    const float du = uv_w / (float) w;
+    const float dv = uv_h / (float) h;
+
+    const ImHui_Soft_Color color = imhui_soft_color(quad->color);
+    const bool solid = image == NULL && imhui_soft_solid_uv(soft, uv_x, uv_y, uv_x + uv_w, uv_y + uv_h);
+    const float texels = fmaxf(du * (float) soft->font_width, dv * (float) soft->font_height);
+
+    for (int y = y0; y < y1; ++y) {
+        uint32_t *row = soft->pixels + (size_t) y * soft->width;
+        if (solid) {
+            imhui_soft_fill_span(row, x0, x1, &color);
+            continue;
+        }
+
+        const float v = uv_y + ((float) (y - quad->rect[1]) + 0.5f) * dv;
+        float u = uv_x + ((float) (x0 - quad->rect[0]) + 0.5f) * du;
+        for (int x = x0; x < x1; ++x, u += du) {
+            if (image != NULL) {
+                const ImHui_Soft_Color texel = imhui_soft_image_color(image, u, v, quad->color);
+                imhui_soft_blend_pixel((uint8_t*) (row + x), &texel);
+            } else {
+                imhui_soft_blend_coverage((uint8_t*) (row + x), &color, imhui_soft_texel(soft, u, v, texels));
+            }
+        }
+    }
+}
+
+static void imhui_soft_triangle_at(ImHui_Soft *soft, const ImHui *imhui, size_t index, size_t base_vertex,
+                                   const ImHui_Soft_Image *image, ImHui_Soft_Clip clip)
+{
+    const Triangle *t = &imhui->triangles[index];
+    const Vertex *vs[3] = {
+        &imhui->vertices[base_vertex + t->a],
+        &imhui->vertices[base_vertex + t->b],
+        &imhui->vertices[base_vertex + t->c],
+    };
+    imhui_soft_triangle(soft, vs, image, clip);
+}
+
+static int imhui_soft_clip_edge(float x, int lo, int hi)
+{
+    // NOTE: the first pixel whose center is not to the left of x
+    x = ceilf(x - 0.5f);
+    return x < (float) lo ? lo : x > (float) hi ? hi : (int) x;
+}
+
+// Narrows `clip` down to the clip rect of the batch
+static ImHui_Soft_Clip imhui_soft_batch_clip(const ImHui_Batch *batch, ImHui_Soft_Clip clip)
+{
+    return (ImHui_Soft_Clip) {
+        .x0 = imhui_soft_clip_edge(batch->clip.x0, clip.x0, clip.x1),
+        .y0 = imhui_soft_clip_edge(batch->clip.y0, clip.y0, clip.y1),
+        .x1 = imhui_soft_clip_edge(batch->clip.x1, clip.x0, clip.x1),
+        .y1 = imhui_soft_clip_edge(batch->clip.y1, clip.y0, clip.y1),
+    };
+}
+
+static void *imhui_soft_reserve(void *items, size_t item_size, size_t *capacity, size_t required)
+{
+    if (required > *capacity) {
+        size_t new_capacity = *capacity == 0 ? 256 : *capacity;
+        while (new_capacity < required) {
+            new_capacity *= 2;
+        }
+        items = realloc(items, new_capacity * item_size);
+        assert(items != NULL && "imhui_soft_reserve: out of memory");
+        *capacity = new_capacity;
+    }
+    return items;
+}
+
+static size_t imhui_soft_tiles_x(const ImHui_Soft *soft)
+{
+    return (soft->width + IMHUI_SOFT_TILE_SIZE - 1) / IMHUI_SOFT_TILE_SIZE;
+}
+
+static size_t imhui_soft_tiles_y(const ImHui_Soft *soft)
+{
+    return (soft->height + IMHUI_SOFT_TILE_SIZE - 1) / IMHUI_SOFT_TILE_SIZE;
+}
+
+// Range of the tiles [tx0, tx1) x [ty0, ty1) overlapped by a bounding box. False if none.
+static bool imhui_soft_tile_range(const ImHui_Soft *soft, float x0, float y0, float x1, float y1, size_t range[4])
+{
+    if (x1 < 0.0f || y1 < 0.0f || x0 >= (float) soft->width || y0 >= (float) soft->height) {
+        return false;
+    }
+    x0 = x0 < 0.0f ? 0.0f : x0;
+    y0 = y0 < 0.0f ? 0.0f : y0;
+    range[0] = (size_t) x0 / IMHUI_SOFT_TILE_SIZE;
+    range[1] = (size_t) y0 / IMHUI_SOFT_TILE_SIZE;
+    range[2] = x1 >= (float) soft->width ? imhui_soft_tiles_x(soft) : (size_t) x1 / IMHUI_SOFT_TILE_SIZE + 1;
+    range[3] = y1 >= (float) soft->height ? imhui_soft_tiles_y(soft) : (size_t) y1 / IMHUI_SOFT_TILE_SIZE + 1;
+    return true;
+}
+
+static bool imhui_soft_primitive_tiles(const ImHui_Soft *soft, const ImHui *imhui, size_t index, size_t base_vertex, size_t range[4])
+{
+    if (imhui->instanced) {
+        const Quad *q = &imhui->quads[index];
+        return imhui_soft_tile_range(soft, q->rect[0], q->rect[1], q->rect[0] + q->rect[2], q->rect[1] + q->rect[3], range);
+    }
+
+    const Triangle *t = &imhui->triangles[index];
+    const ImHui_Index indices[3] = {t->a, t->b, t->c};
+    float min[2], max[2];
+    for (size_t i = 0; i < 3; ++i) {
+        float position[2], attribs[6];
+        imhui_soft_vertex(&imhui->vertices[base_vertex + indices[i]], position, attribs);
+        for (size_t j = 0; j < 2; ++j) {
+            min[j] = i == 0 ? position[j] : fminf(min[j], position[j]);
+            max[j] = i == 0 ? position[j] : fmaxf(max[j], position[j]);
+        }
+    }
+    return imhui_soft_tile_range(soft, min[0], min[1], max[0], max[1], range);
+}
+
+// Two passes over the primitives: count the entries of every tile, then fill
+// them in. Each bin keeps the submission order, so the tiles blend exactly like
+// the single threaded path.
+static void imhui_soft_bin(ImHui_Soft *soft, const ImHui *imhui, size_t first_batch, size_t last_batch)
+{
+    const size_t tiles_x = imhui_soft_tiles_x(soft);
+    const size_t tiles_count = tiles_x * imhui_soft_tiles_y(soft);
+
+    soft->bin_offsets = imhui_soft_reserve(soft->bin_offsets, sizeof(*soft->bin_offsets), &soft->bin_offsets_capacity, tiles_count + 1);
+    memset(soft->bin_offsets, 0, (tiles_count + 1) * sizeof(*soft->bin_offsets));
+
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t b = first_batch; b < last_batch; ++b) {
+            const ImHui_Batch *batch = &imhui->batches[b];
+            const size_t first = imhui->instanced ? batch->first_quad : batch->first_triangle;
+            const size_t count = imhui->instanced ? batch->quads_count : batch->triangles_count;
+            const size_t base_vertex = imhui->instanced ? 0 : batch->base_vertex;
+
+            for (size_t i = first; i < first + count; ++i) {
+                size_t range[4];
+                if (!imhui_soft_primitive_tiles(soft, imhui, i, base_vertex, range)) {
+                    continue;
+                }
+                for (size_t ty = range[1]; ty < range[3]; ++ty) {
+                    for (size_t tx = range[0]; tx < range[2]; ++tx) {
+                        const size_t tile = ty * tiles_x + tx;
+                        if (pass == 0) {
+                            soft->bin_offsets[tile + 1] += 1;
+                        } else {
+                            soft->bin_entries[soft->bin_offsets[tile]++] = (ImHui_Soft_Bin_Entry) {
+                                .index = (uint32_t) i,
+                                .base_vertex = (uint32_t) base_vertex,
+                                .batch = (uint32_t) b,
+                            };
+                        }
+                    }
+                }
+            }
+        }
+
+        if (pass == 0) {
+            for (size_t i = 0; i < tiles_count; ++i) {
+                soft->bin_offsets[i + 1] += soft->bin_offsets[i];
+            }
+            soft->bin_entries = imhui_soft_reserve(
+                                    soft->bin_entries,
+                                    sizeof(*soft->bin_entries),
+                                    &soft->bin_entries_capacity,
+                                    soft->bin_offsets[tiles_count]);
+        } else {
+            // The fill pass advanced every offset to the beginning of the next bin
+            memmove(soft->bin_offsets + 1, soft->bin_offsets, tiles_count * sizeof(*soft->bin_offsets));
+            soft->bin_offsets[0] = 0;
+        }
+    }
+}
+
+typedef struct {
+    ImHui_Soft *soft;
+    const ImHui *imhui;
+    atomic_size_t next_tile;
+    size_t tiles_count;
+} ImHui_Soft_Job;
+
+static void *imhui_soft_worker(void *arg)
+{
+    ImHui_Soft_Job *job = arg;
+    ImHui_Soft *soft = job->soft;
+    const size_t tiles_x = imhui_soft_tiles_x(soft);
+
+    for (;;) {
+        const size_t tile = atomic_fetch_add(&job->next_tile, 1);
+        if (tile >= job->tiles_count) {
+            break;
+        }
+
+        const int x0 = (int) (tile % tiles_x * IMHUI_SOFT_TILE_SIZE);
+        const int y0 = (int) (tile / tiles_x * IMHUI_SOFT_TILE_SIZE);
+        const ImHui_Soft_Clip tile_clip = {
+            .x0 = x0,
+            .y0 = y0,
+            .x1 = x0 + IMHUI_SOFT_TILE_SIZE < (int) soft->width ? x0 + IMHUI_SOFT_TILE_SIZE : (int) soft->width,
+            .y1 = y0 + IMHUI_SOFT_TILE_SIZE < (int) soft->height ? y0 + IMHUI_SOFT_TILE_SIZE : (int) soft->height,
+        };
+
+        for (size_t i = soft->bin_offsets[tile]; i < soft->bin_offsets[tile + 1]; ++i) {
+            const ImHui_Soft_Bin_Entry *entry = &soft->bin_entries[i];
+            const ImHui_Batch *batch = &job->imhui->batches[entry->batch];
+            const ImHui_Soft_Image *image = (const ImHui_Soft_Image*) batch->texture;
+            const ImHui_Soft_Clip clip = imhui_soft_batch_clip(batch, tile_clip);
+            if (job->imhui->instanced) {
+                imhui_soft_quad(soft, &job->imhui->quads[entry->index], image, clip);
+            } else {
+                imhui_soft_triangle_at(soft, job->imhui, entry->index, entry->base_vertex, image, clip);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+void imhui_soft_free(ImHui_Soft *soft)
+{
+    free(soft->bin_offsets);
+    free(soft->bin_entries);
+    soft->bin_offsets = NULL;
+    soft->bin_offsets_capacity = 0;
+    soft->bin_entries = NULL;
+    soft->bin_entries_capacity = 0;
+}
+
+void imhui_soft_clear(ImHui_Soft *soft, RGBA color)
+{
+    const uint8_t bytes[4] = {
+        imhui_soft_unorm8(color.r),
+        imhui_soft_unorm8(color.g),
+        imhui_soft_unorm8(color.b),
+        imhui_soft_unorm8(color.a),
+    };
+    uint32_t packed;
+    memcpy(&packed, bytes, 4);
+    for (size_t i = 0; i < soft->width * soft->height; ++i) {
+        soft->pixels[i] = packed;
+    }
+}
+
+// Rasterizes the batches [first_batch, last_batch), none of which is a callback
+static void imhui_soft_render_batches(ImHui_Soft *soft, const ImHui *imhui, size_t first_batch, size_t last_batch)
+{
+    if (first_batch == last_batch) {
+        return;
+    }
+
+    if (soft->threads <= 1) {
+        const ImHui_Soft_Clip canvas = {0, 0, (int) soft->width, (int) soft->height};
+        for (size_t b = first_batch; b < last_batch; ++b) {
+            const ImHui_Batch *batch = &imhui->batches[b];
+            const ImHui_Soft_Image *image = (const ImHui_Soft_Image*) batch->texture;
+            const ImHui_Soft_Clip clip = imhui_soft_batch_clip(batch, canvas);
+            for (size_t i = 0; i < batch->quads_count; ++i) {
+                imhui_soft_quad(soft, &imhui->quads[batch->first_quad + i], image, clip);
+            }
+            for (size_t i = 0; i < batch->triangles_count; ++i) {
+                imhui_soft_triangle_at(soft, imhui, batch->first_triangle + i, batch->base_vertex, image, clip);
+            }
+        }
+        return;
+    }
+
+    imhui_soft_bin(soft, imhui, first_batch, last_batch);
+
+    ImHui_Soft_Job job = {
+        .soft = soft,
+        .imhui = imhui,
+        .tiles_count = imhui_soft_tiles_x(soft) * imhui_soft_tiles_y(soft),
+    };
+    atomic_init(&job.next_tile, 0);
+
+    const size_t threads_count = soft->threads < IMHUI_SOFT_MAX_THREADS ? soft->threads : IMHUI_SOFT_MAX_THREADS;
+    pthread_t threads[IMHUI_SOFT_MAX_THREADS];
+    // NOTE: the calling thread is one of the workers
+    size_t started = 0;
+    for (size_t i = 1; i < threads_count; ++i) {
+        if (pthread_create(&threads[started], NULL, imhui_soft_worker, &job) == 0) {
+            started += 1;
+        }
+    }
+    imhui_soft_worker(&job);
+    for (size_t i = 0; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+// NOTE: the callbacks are called on the calling thread once everything
+// before them is rasterized, so they may draw into `pixels` as well.
+void imhui_soft_render(ImHui_Soft *soft, const ImHui *imhui)
+{
+    assert(soft->pixels != NULL);
+
+    soft->font_spread = 0.0f;
+    if (imhui->sdf != NULL) {
+        soft->font = imhui->sdf->pixels;
+        soft->font_width = (int) imhui->sdf->width;
+        soft->font_height = (int) imhui->sdf->height;
+        soft->font_spread = imhui->sdf->spread;
+    } else if (imhui->atlas.active) {
+        soft->font = imhui->atlas.pixels;
+        soft->font_width = IMHUI_ATLAS_WIDTH;
+        soft->font_height = IMHUI_ATLAS_HEIGHT;
+    } else {
+        soft->font = FONT;
+        soft->font_width = FONT_WIDTH;
+        soft->font_height = FONT_HEIGHT;
+    }
+
+    size_t first = 0;
+    for (size_t b = 0; b < imhui->batches_count; ++b) {
+        const ImHui_Batch *batch = &imhui->batches[b];
+        if (batch->callback != NULL) {
+            imhui_soft_render_batches(soft, imhui, first, b);
+            batch->callback(imhui, batch);
+            first = b + 1;
+        }
+    }
+    imhui_soft_render_batches(soft, imhui, first, imhui->batches_count);
+}
+
+bool imhui_soft_save_ppm(const ImHui_Soft *soft, const char *file_path)
+{
+    FILE *f = fopen(file_path, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "ERROR: could not open file %s: %s\n", file_path, strerror(errno));
+        return false;
+    }
+
+    fprintf(f, "P6\n%zu %zu\n255\n", soft->width, soft->height);
+    for (size_t i = 0; i < soft->width * soft->height; ++i) {
+        const uint8_t *pixel = (const uint8_t*) &soft->pixels[i];
+        fwrite(pixel, 1, 3, f);
+    }
+
+    const bool ok = !ferror(f);
+    if (!ok) {
+        fprintf(stderr, "ERROR: could not write file %s: %s\n", file_path, strerror(errno));
+    }
+    fclose(f);
+    return ok;
+}
+
+static uint32_t imhui_soft_crc32(uint32_t crc, const uint8_t *data, size_t size)
+{
+    static uint32_t table[256];
+    if (table[1] == 0) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void imhui_soft_put_u32_be(uint8_t *p, uint32_t x)
+{
+    p[0] = (uint8_t) (x >> 24);
+    p[1] = (uint8_t) (x >> 16);
+    p[2] = (uint8_t) (x >> 8);
+    p[3] = (uint8_t) x;
+}
+
+static void imhui_soft_png_chunk(FILE *f, const char type[4], const uint8_t *data, size_t size)
+{
+    uint8_t header[8];
+    imhui_soft_put_u32_be(header, (uint32_t) size);
+    memcpy(header + 4, type, 4);
+    fwrite(header, 1, sizeof(header), f);
+    if (size > 0) {
+        fwrite(data, 1, size, f);
+    }
+
+    uint8_t crc[4];
+    imhui_soft_put_u32_be(crc, imhui_soft_crc32(imhui_soft_crc32(0, header + 4, 4), data, size));
+    fwrite(crc, 1, sizeof(crc), f);
+}
+
+// NOTE: the image data is stored with uncompressed deflate blocks. The files
+// are bigger than they could be, but byte exact and trivial to diff.
+bool imhui_soft_save_png(const ImHui_Soft *soft, const char *file_path)
+{
+    const size_t BLOCK_SIZE = 65535;
+    const size_t row_size = 1 + soft->width * 4;
+    const size_t raw_size = row_size * soft->height;
+    const size_t blocks_count = raw_size == 0 ? 1 : (raw_size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const size_t idat_size = 2 + blocks_count * 5 + raw_size + 4;
+
+    uint8_t *idat = malloc(idat_size);
+    assert(idat != NULL && "imhui_soft_save_png: out of memory");
+
+    // zlib header, no compression
+    idat[0] = 0x78;
+    idat[1] = 0x01;
+
+    uint32_t adler_a = 1, adler_b = 0;
+    size_t raw_offset = 0;
+    uint8_t *out = idat + 2;
+    for (size_t block = 0; block < blocks_count; ++block) {
+        const size_t size = raw_size - raw_offset < BLOCK_SIZE ? raw_size - raw_offset : BLOCK_SIZE;
+        out[0] = block + 1 == blocks_count;
+        out[1] = (uint8_t) size;
+        out[2] = (uint8_t) (size >> 8);
+        out[3] = (uint8_t) ~size;
+        out[4] = (uint8_t) (~size >> 8);
+        out += 5;
+
+        for (size_t i = 0; i < size; ++i, ++raw_offset) {
+            const size_t y = raw_offset / row_size;
+            const size_t x = raw_offset % row_size;
+            // Every row starts with the filter type 0 (None)
+            const uint8_t byte = x == 0 ? 0 : ((const uint8_t*) (soft->pixels + y * soft->width))[x - 1];
+            *out++ = byte;
+            adler_a = (adler_a + byte) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+        }
+    }
+    imhui_soft_put_u32_be(out, (adler_b << 16) | adler_a);
+
+    FILE *f = fopen(file_path, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "ERROR: could not open file %s: %s\n", file_path, strerror(errno));
+        free(idat);
+        return false;
+    }
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(signature, 1, sizeof(signature), f);
+
+    uint8_t ihdr[13];
+    imhui_soft_put_u32_be(ihdr + 0, (uint32_t) soft->width);
+    imhui_soft_put_u32_be(ihdr + 4, (uint32_t) soft->height);
+    ihdr[8] = 8;                // bit depth
+    ihdr[9] = 6;                // color type RGBA
+    ihdr[10] = 0;               // compression
+    ihdr[11] = 0;               // filter
+    ihdr[12] = 0;               // interlace
+    imhui_soft_png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+    imhui_soft_png_chunk(f, "IDAT", idat, idat_size);
+    imhui_soft_png_chunk(f, "IEND", NULL, 0);
+
+    free(idat);
+
+    const bool ok = !ferror(f);
+    if (!ok) {
+        fprintf(stderr, "ERROR: could not write file %s: %s\n", file_path, strerror(errno));
+    }
+    fclose(f);
+    return ok;
+}
+
+#endif // IMHUI_SOFT_IMPLEMENTATION
@@ -1,8 +1,16 @@
+#define _POSIX_C_SOURCE 200809L
 #include <assert.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
+#include <errno.h>
 #include <math.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #define GLEW_STATIC
 #include <GL/glew.h>
 
@@ -38,18 +46,63 @@ const char *const vert_shader_source =
     "}\n"
     "\n";
 
+// Vertex shader of the instanced mode. Every instance is a Quad that stretches
+// the unit quad provided through the `corner` attribute.
+const char *const quad_vert_shader_source =
+    "#version 330 core\n"
+    "\n"
+    "uniform vec2 resolution;\n"
+    "\n"
+    "layout(location = 0) in vec2 corner;\n"
+    "layout(location = 1) in vec4 rect;\n"
+    "layout(location = 2) in vec4 uv_rect;\n"
+    "layout(location = 3) in vec4 color;\n"
+    "\n"
+    "out vec4 output_color;\n"
+    "out vec2 output_uv;\n"
+    "\n"
+    "vec2 flip(vec2 p) {\n"
+    "    return vec2(p.x, resolution.y - p.y);\n"
+    "}\n"
+    "\n"
+    "void main() {\n"
+    "    vec2 position = rect.xy + corner * rect.zw;\n"
+    "    gl_Position = vec4((flip(position) - resolution * 0.5) / (resolution * 0.5), 0.0, 1.0);\n"
+    "    output_color = color;\n"
+    "    output_uv = uv_rect.xy + corner * uv_rect.zw;\n"
+    "}\n"
+    "\n";
+
 const char *const frag_shader_source =
     "#version 330 core\n"
     "\n"
-    "uniform sampler2D font;\n"
+    "uniform sampler2D image;\n"
+    "\n"
+    "in vec4 output_color;\n"
+    "in vec2 output_uv;\n"
+    "out vec4 final_color;\n"
+    "\n"
+    "void main() {\n"
+    "    final_color = texture(image, output_uv) * output_color;\n"
+    "}\n"
+    "\n";
+
+// Fragment shader of the text of the SDF font. The texture 0 holds the distances
+// to the outlines, which are thresholded at 0.5 and antialiased over a pixel.
+const char *const sdf_frag_shader_source =
+    "#version 330 core\n"
+    "\n"
+    "uniform sampler2D image;\n"
     "\n"
     "in vec4 output_color;\n"
     "in vec2 output_uv;\n"
     "out vec4 final_color;\n"
     "\n"
     "void main() {\n"
-    "    vec4 pixel = texture(font, output_uv);\n"
-    "    final_color = pixel.x * output_color;\n"
+    "    float d = texture(image, output_uv).a;\n"
+    "    float w = max(fwidth(d), 1e-5);\n"
+    "    float coverage = clamp((d - 0.5) / w + 0.5, 0.0, 1.0);\n"
+    "    final_color = vec4(output_color.rgb, output_color.a * coverage);\n"
     "}\n"
     "\n";
 
@@ -107,6 +160,22 @@ bool link_program(GLuint vert_shader, GLuint frag_shader, GLuint *program)
     return program;
 }
 
+#ifdef IMHUI_PACKED_VERTICES
+#define IMHUI_POSITION_GL_TYPE GL_SHORT
+#define IMHUI_COLOR_GL_TYPE GL_UNSIGNED_BYTE
+#define IMHUI_UV_GL_TYPE GL_UNSIGNED_SHORT
+#else
+#define IMHUI_POSITION_GL_TYPE GL_FLOAT
+#define IMHUI_COLOR_GL_TYPE GL_FLOAT
+#define IMHUI_UV_GL_TYPE GL_FLOAT
+#endif // IMHUI_PACKED_VERTICES
+
+#ifdef IMHUI_INDEX16
+#define IMHUI_INDEX_GL_TYPE GL_UNSIGNED_SHORT
+#else
+#define IMHUI_INDEX_GL_TYPE GL_UNSIGNED_INT
+#endif // IMHUI_INDEX16
+
 typedef enum {
     IMHUI_POSITION_ATTRIB = 0,
     IMHUI_COLOR_ATTRIB,
@@ -114,24 +183,61 @@ typedef enum {
     COUNT_IMHUI_ATTRIBS
 } ImHui_Attribs;
 
+typedef enum {
+    IMHUI_QUAD_CORNER_ATTRIB = 0,
+    IMHUI_QUAD_RECT_ATTRIB,
+    IMHUI_QUAD_UV_ATTRIB,
+    IMHUI_QUAD_COLOR_ATTRIB,
+    COUNT_IMHUI_QUAD_ATTRIBS
+} ImHui_Quad_Attribs;
+
+// NOTE: the streaming ring has one region per frame in flight. The CPU fills
+// one region while the GPU may still be reading from the other two.
+#define IMHUI_GL_STREAM_REGIONS 3
+#define IMHUI_GL_STREAM_INITIAL_REGION_SIZE (64 * 1024)
+#define IMHUI_GL_STREAM_ALIGNMENT 256
+
 typedef struct {
     GLuint vao;
     GLuint vert_vbo;
+    size_t vert_vbo_capacity;
+    GLuint index_ebo;
+    size_t index_ebo_capacity;
+
+    GLuint quad_vao;
+    GLuint unit_vbo;
+    GLuint quad_vbo;
+    size_t quad_vbo_capacity;
+
+    // Streaming mode: a single persistently mapped buffer split into
+    // IMHUI_GL_STREAM_REGIONS regions, each guarded by its own fence.
+    bool streaming;
+    GLuint stream_buffer;
+    char *stream_memory;
+    size_t stream_region_size;
+    size_t stream_region;
+    GLsync stream_fences[IMHUI_GL_STREAM_REGIONS];
+
     GLuint font_texture;
-} ImHui_GL;
+    GLuint atlas_texture;       // created on the first frame with the glyph atlas
+    GLuint sdf_texture;         // created on the first frame with the SDF font
 
-void imhui_gl_begin(ImHui_GL *imhui_gl, const ImHui *imhui)
-{
-    glGenVertexArrays(1, &imhui_gl->vao);
-    glBindVertexArray(imhui_gl->vao);
+    // The batches of the texture 0 go through `sdf_program` with the SDF font
+    GLuint program;
+    GLuint sdf_program;
+} ImHui_GL;
 
-    glGenBuffers(1, &imhui_gl->vert_vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, imhui_gl->vert_vbo);
-    glBufferData(GL_ARRAY_BUFFER,
-                 sizeof(imhui->vertices),
-                 imhui->vertices,
-                 GL_DYNAMIC_DRAW);
+static const GLfloat unit_quad[] = {
+    0.0f, 0.0f,
+    1.0f, 0.0f,
+    0.0f, 1.0f,
+    1.0f, 1.0f,
+};
 
+// Points the vertex attributes of the currently bound VAO at the vertices
+// that start `offset` bytes into the currently bound GL_ARRAY_BUFFER.
+static void imhui_gl_vertex_attribs(size_t offset)
+{
     // Position
     {
         const ImHui_Attribs attrib = IMHUI_POSITION_ATTRIB;
@@ -139,10 +245,10 @@ void imhui_gl_begin(ImHui_GL *imhui_gl, const ImHui *imhui)
         glVertexAttribPointer(
             attrib,             // index
             2,                  // numComponents
-            GL_FLOAT,           // type
-            0,                  // normalized
-            sizeof(imhui->vertices[0]), // stride
-            (void*) offsetof(Vertex, position)  // offset
+            IMHUI_POSITION_GL_TYPE, // type
+            GL_FALSE,           // normalized
+            sizeof(Vertex),     // stride
+            (void*) (offset + offsetof(Vertex, position)) // offset
         );
     }
 
@@ -153,10 +259,10 @@ void imhui_gl_begin(ImHui_GL *imhui_gl, const ImHui *imhui)
         glVertexAttribPointer(
             attrib,             // index
             4,                  // numComponents
-            GL_FLOAT,           // type
-            0,                  // normalized
-            sizeof(imhui->vertices[0]), // stride
-            (void*) offsetof(Vertex, color)     // offset
+            IMHUI_COLOR_GL_TYPE, // type
+            IMHUI_COLOR_GL_TYPE != GL_FLOAT, // normalized
+            sizeof(Vertex),     // stride
+            (void*) (offset + offsetof(Vertex, color))    // offset
         );
     }
 
@@ -167,14 +273,97 @@ void imhui_gl_begin(ImHui_GL *imhui_gl, const ImHui *imhui)
         glVertexAttribPointer(
             attrib,             // index
             2,                  // numComponents
-            GL_FLOAT,           // type
-            0,                  // normalized
-            sizeof(imhui->vertices[0]), // stride
-            (void*) offsetof(Vertex, uv)        // offset
+            IMHUI_UV_GL_TYPE,   // type
+            IMHUI_UV_GL_TYPE != GL_FLOAT, // normalized
+            sizeof(Vertex),     // stride
+            (void*) (offset + offsetof(Vertex, uv))       // offset
         );
     }
 
     static_assert(COUNT_IMHUI_ATTRIBS == 3, "The amount of ImHui Vertex attributes have changed");
+}
+
+// Same as imhui_gl_vertex_attribs() but for the per instance Quad attributes.
+static void imhui_gl_quad_attribs(size_t offset)
+{
+    // Rect
+    {
+        const ImHui_Quad_Attribs attrib = IMHUI_QUAD_RECT_ATTRIB;
+        glEnableVertexAttribArray(attrib);
+        glVertexAttribPointer(attrib, 4, GL_SHORT, GL_FALSE, sizeof(Quad), (void*) (offset + offsetof(Quad, rect)));
+        glVertexAttribDivisor(attrib, 1);
+    }
+
+    // UV Rect
+    {
+        const ImHui_Quad_Attribs attrib = IMHUI_QUAD_UV_ATTRIB;
+        glEnableVertexAttribArray(attrib);
+        glVertexAttribPointer(attrib, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(Quad), (void*) (offset + offsetof(Quad, uv)));
+        glVertexAttribDivisor(attrib, 1);
+    }
+
+    // Color
+    {
+        const ImHui_Quad_Attribs attrib = IMHUI_QUAD_COLOR_ATTRIB;
+        glEnableVertexAttribArray(attrib);
+        glVertexAttribPointer(attrib, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Quad), (void*) (offset + offsetof(Quad, color)));
+        glVertexAttribDivisor(attrib, 1);
+    }
+
+    static_assert(COUNT_IMHUI_QUAD_ATTRIBS == 4, "The amount of ImHui Quad attributes have changed");
+}
+
+void imhui_gl_begin(ImHui_GL *imhui_gl, const ImHui *imhui)
+{
+    if (imhui_gl->streaming && !(GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)) {
+        fprintf(stderr, "WARNING: GL_ARB_buffer_storage is not supported, falling back to glBufferSubData() uploads\n");
+        imhui_gl->streaming = false;
+    }
+
+    glGenVertexArrays(1, &imhui_gl->vao);
+    glBindVertexArray(imhui_gl->vao);
+
+    glGenBuffers(1, &imhui_gl->vert_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, imhui_gl->vert_vbo);
+    glBufferData(GL_ARRAY_BUFFER,
+                 imhui->vertices_capacity * sizeof(imhui->vertices[0]),
+                 imhui->vertices,
+                 GL_DYNAMIC_DRAW);
+    imhui_gl->vert_vbo_capacity = imhui->vertices_capacity;
+
+    imhui_gl_vertex_attribs(0);
+
+    glGenBuffers(1, &imhui_gl->index_ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, imhui_gl->index_ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 imhui->triangles_capacity * sizeof(imhui->triangles[0]),
+                 imhui->triangles,
+                 GL_DYNAMIC_DRAW);
+    imhui_gl->index_ebo_capacity = imhui->triangles_capacity;
+
+    glGenVertexArrays(1, &imhui_gl->quad_vao);
+    glBindVertexArray(imhui_gl->quad_vao);
+
+    glGenBuffers(1, &imhui_gl->unit_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, imhui_gl->unit_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(unit_quad), unit_quad, GL_STATIC_DRAW);
+
+    // Corner
+    {
+        const ImHui_Quad_Attribs attrib = IMHUI_QUAD_CORNER_ATTRIB;
+        glEnableVertexAttribArray(attrib);
+        glVertexAttribPointer(attrib, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void*) 0);
+    }
+
+    glGenBuffers(1, &imhui_gl->quad_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, imhui_gl->quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER,
+                 imhui->quads_capacity * sizeof(imhui->quads[0]),
+                 imhui->quads,
+                 GL_DYNAMIC_DRAW);
+    imhui_gl->quad_vbo_capacity = imhui->quads_capacity;
+
+    imhui_gl_quad_attribs(0);
 
     // Font Texture
     {
@@ -188,38 +377,352 @@ void imhui_gl_begin(ImHui_GL *imhui_gl, const ImHui *imhui)
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
+        // NOTE: the font is sampled as (1, 1, 1, coverage), so it goes through the
+        // same shader as the RGBA textures of imhui_image()
+        const GLint swizzle[] = {GL_ONE, GL_ONE, GL_ONE, GL_RED};
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+
         glTexImage2D(GL_TEXTURE_2D,
                      0,
-                     GL_RGBA,
+                     GL_R8,
                      FONT_WIDTH,
                      FONT_HEIGHT,
                      0,
-                     GL_LUMINANCE,
+                     GL_RED,
                      GL_UNSIGNED_BYTE,
                      FONT);
         glGenerateMipmap(GL_TEXTURE_2D);
     }
 }
 
+static GLint imhui_gl_clamp(float x, GLint max)
+{
+    return x < 0.0f ? 0 : x > (float) max ? max : (GLint) x;
+}
+
+// Maps the clip rect of the batch from the ImHui pixels onto the viewport.
+// NOTE: the clip rects are already applied to the geometry on the CPU side,
+// so the scissor only matters for whatever the CPU could not trim.
+static void imhui_gl_scissor(const GLint viewport[4], const ImHui_Batch *batch)
+{
+    const GLint x0 = imhui_gl_clamp(floorf(batch->clip.x0), viewport[2]);
+    const GLint y0 = imhui_gl_clamp(floorf(batch->clip.y0), viewport[3]);
+    const GLint x1 = imhui_gl_clamp(ceilf(batch->clip.x1), viewport[2]);
+    const GLint y1 = imhui_gl_clamp(ceilf(batch->clip.y1), viewport[3]);
+    glScissor(viewport[0] + x0, viewport[1] + viewport[3] - y1, x1 - x0, y1 - y0);
+}
+
+// Sets up the state of the batch. False if the batch is a callback, which is called right away.
+static bool imhui_gl_bind_batch(const ImHui_GL *imhui_gl, const ImHui *imhui, const GLint viewport[4], const ImHui_Batch *batch)
+{
+    if (batch->callback != NULL) {
+        batch->callback(imhui, batch);
+        return false;
+    }
+
+    imhui_gl_scissor(viewport, batch);
+    if (imhui_gl->sdf_program != 0) {
+        glUseProgram(batch->texture == 0 && imhui->sdf != NULL ? imhui_gl->sdf_program : imhui_gl->program);
+    }
+    if (batch->texture != 0) {
+        glBindTexture(GL_TEXTURE_2D, (GLuint) batch->texture);
+    } else if (imhui->sdf != NULL) {
+        glBindTexture(GL_TEXTURE_2D, imhui_gl->sdf_texture);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, imhui->atlas.active ? imhui_gl->atlas_texture : imhui_gl->font_texture);
+    }
+    return true;
+}
+
+// Uploads only the part of the glyph atlas that changed during the frame
+static void imhui_gl_upload_atlas(ImHui_GL *imhui_gl, const ImHui *imhui)
+{
+    const ImHui_Atlas *atlas = &imhui->atlas;
+    if (!atlas->active) {
+        return;
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    if (imhui_gl->atlas_texture == 0) {
+        glGenTextures(1, &imhui_gl->atlas_texture);
+        glBindTexture(GL_TEXTURE_2D, imhui_gl->atlas_texture);
+
+        // NOTE: the glyphs are rasterized at the size they are drawn at, so there is nothing to filter
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        const GLint swizzle[] = {GL_ONE, GL_ONE, GL_ONE, GL_RED};
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+
+        glTexImage2D(GL_TEXTURE_2D,
+                     0,
+                     GL_R8,
+                     IMHUI_ATLAS_WIDTH,
+                     IMHUI_ATLAS_HEIGHT,
+                     0,
+                     GL_RED,
+                     GL_UNSIGNED_BYTE,
+                     NULL);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, imhui_gl->atlas_texture);
+    }
+
+    if (atlas->dirty_x0 < atlas->dirty_x1) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, IMHUI_ATLAS_WIDTH);
+        glTexSubImage2D(GL_TEXTURE_2D,
+                        0,
+                        atlas->dirty_x0,
+                        atlas->dirty_y0,
+                        atlas->dirty_x1 - atlas->dirty_x0,
+                        atlas->dirty_y1 - atlas->dirty_y0,
+                        GL_RED,
+                        GL_UNSIGNED_BYTE,
+                        &atlas->pixels[atlas->dirty_y0 * IMHUI_ATLAS_WIDTH + atlas->dirty_x0]);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+}
+
+// The SDF font is uploaded once, it never changes
+static void imhui_gl_upload_sdf(ImHui_GL *imhui_gl, const ImHui *imhui)
+{
+    const ImHui_Sdf_Font *sdf = imhui->sdf;
+    if (sdf == NULL || imhui_gl->sdf_texture != 0) {
+        return;
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    glGenTextures(1, &imhui_gl->sdf_texture);
+    glBindTexture(GL_TEXTURE_2D, imhui_gl->sdf_texture);
+
+    // NOTE: the distances are interpolated, that is what keeps the outlines smooth at any scale
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    const GLint swizzle[] = {GL_ONE, GL_ONE, GL_ONE, GL_RED};
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 GL_R8,
+                 sdf->width,
+                 sdf->height,
+                 0,
+                 GL_RED,
+                 GL_UNSIGNED_BYTE,
+                 sdf->pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+// Draws all the batches with their indices starting `indices_offset` bytes
+// into the currently bound GL_ELEMENT_ARRAY_BUFFER.
+static void imhui_gl_draw_batches(const ImHui_GL *imhui_gl, const ImHui *imhui, size_t indices_offset)
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glEnable(GL_SCISSOR_TEST);
+    for (size_t i = 0; i < imhui->batches_count; ++i) {
+        const ImHui_Batch *batch = &imhui->batches[i];
+        if (!imhui_gl_bind_batch(imhui_gl, imhui, viewport, batch)) {
+            continue;
+        }
+        glDrawElementsBaseVertex(GL_TRIANGLES,
+                                 batch->triangles_count * TRIANGLE_COUNT,
+                                 IMHUI_INDEX_GL_TYPE,
+                                 (void*) (indices_offset + batch->first_triangle * sizeof(imhui->triangles[0])),
+                                 batch->base_vertex);
+    }
+    glDisable(GL_SCISSOR_TEST);
+}
+
+// Draws all the batches of the instanced mode with the quads starting
+// `quads_offset` bytes into the currently bound GL_ARRAY_BUFFER.
+static void imhui_gl_draw_quad_batches(const ImHui_GL *imhui_gl, const ImHui *imhui, size_t quads_offset)
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glEnable(GL_SCISSOR_TEST);
+    for (size_t i = 0; i < imhui->batches_count; ++i) {
+        const ImHui_Batch *batch = &imhui->batches[i];
+        if (!imhui_gl_bind_batch(imhui_gl, imhui, viewport, batch)) {
+            continue;
+        }
+        imhui_gl_quad_attribs(quads_offset + batch->first_quad * sizeof(imhui->quads[0]));
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, batch->quads_count);
+    }
+    glDisable(GL_SCISSOR_TEST);
+}
+
+static void imhui_gl_stream_wait(GLsync *fence)
+{
+    if (*fence != NULL) {
+        // NOTE: the timeout only limits a single call, the region must not be
+        // touched until the GPU is really done with it.
+        while (glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(*fence);
+        *fence = NULL;
+    }
+}
+
+static void imhui_gl_stream_reserve(ImHui_GL *imhui_gl, size_t required)
+{
+    if (required <= imhui_gl->stream_region_size) {
+        return;
+    }
+
+    size_t region_size = imhui_gl->stream_region_size;
+    if (region_size == 0) {
+        region_size = IMHUI_GL_STREAM_INITIAL_REGION_SIZE;
+    }
+    while (region_size < required) {
+        region_size *= 2;
+    }
+
+    // NOTE: the storage of the stream buffer is immutable, so growing it means
+    // draining the whole ring and mapping a new buffer.
+    for (size_t i = 0; i < IMHUI_GL_STREAM_REGIONS; ++i) {
+        imhui_gl_stream_wait(&imhui_gl->stream_fences[i]);
+    }
+
+    if (imhui_gl->stream_buffer != 0) {
+        glBindBuffer(GL_ARRAY_BUFFER, imhui_gl->stream_buffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glDeleteBuffers(1, &imhui_gl->stream_buffer);
+    }
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &imhui_gl->stream_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, imhui_gl->stream_buffer);
+    glBufferStorage(GL_ARRAY_BUFFER, region_size * IMHUI_GL_STREAM_REGIONS, NULL, flags);
+    imhui_gl->stream_memory = glMapBufferRange(GL_ARRAY_BUFFER, 0, region_size * IMHUI_GL_STREAM_REGIONS, flags);
+    assert(imhui_gl->stream_memory != NULL && "Could not map the stream buffer");
+
+    imhui_gl->stream_region_size = region_size;
+    imhui_gl->stream_region = 0;
+}
+
+// NOTE: ImHui keeps the previous frame around on the CPU side for the vertex
+// cache, so the geometry is built in regular memory and copied once into the
+// mapped region. Reading back from write-combined GPU memory would be far
+// slower than this single memcpy.
+static void imhui_gl_stream_render(ImHui_GL *imhui_gl, const ImHui *imhui)
+{
+    const size_t vertices_size = imhui->instanced
+        ? imhui->quads_count * sizeof(imhui->quads[0])
+        : imhui->vertices_count * sizeof(imhui->vertices[0]);
+    const size_t indices_size = imhui->instanced
+        ? 0
+        : imhui->triangles_count * sizeof(imhui->triangles[0]);
+    if (vertices_size == 0 && imhui->batches_count == 0) {
+        return;
+    }
+
+    const size_t indices_offset =
+        (vertices_size + IMHUI_GL_STREAM_ALIGNMENT - 1) / IMHUI_GL_STREAM_ALIGNMENT * IMHUI_GL_STREAM_ALIGNMENT;
+    imhui_gl_stream_reserve(imhui_gl, indices_offset + indices_size);
+
+    const size_t region = imhui_gl->stream_region;
+    imhui_gl_stream_wait(&imhui_gl->stream_fences[region]);
+
+    const size_t region_offset = region * imhui_gl->stream_region_size;
+    char *const memory = imhui_gl->stream_memory + region_offset;
+
+    glBindBuffer(GL_ARRAY_BUFFER, imhui_gl->stream_buffer);
+    if (imhui->instanced) {
+        memcpy(memory, imhui->quads, vertices_size);
+        glBindVertexArray(imhui_gl->quad_vao);
+        imhui_gl_draw_quad_batches(imhui_gl, imhui, region_offset);
+    } else {
+        memcpy(memory, imhui->vertices, vertices_size);
+        memcpy(memory + indices_offset, imhui->triangles, indices_size);
+        glBindVertexArray(imhui_gl->vao);
+        imhui_gl_vertex_attribs(region_offset);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, imhui_gl->stream_buffer);
+        imhui_gl_draw_batches(imhui_gl, imhui, region_offset + indices_offset);
+    }
+
+    imhui_gl->stream_fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    imhui_gl->stream_region = (region + 1) % IMHUI_GL_STREAM_REGIONS;
+}
+
 void imhui_gl_render(ImHui_GL *imhui_gl, const ImHui *imhui)
 {
+    imhui_gl_upload_atlas(imhui_gl, imhui);
+    imhui_gl_upload_sdf(imhui_gl, imhui);
+
+    if (imhui_gl->streaming) {
+        imhui_gl_stream_render(imhui_gl, imhui);
+        return;
+    }
+
+    if (imhui->instanced) {
+        glBindVertexArray(imhui_gl->quad_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, imhui_gl->quad_vbo);
+        if (imhui->quads_count > imhui_gl->quad_vbo_capacity) {
+            glBufferData(GL_ARRAY_BUFFER,
+                         imhui->quads_capacity * sizeof(imhui->quads[0]),
+                         NULL,
+                         GL_DYNAMIC_DRAW);
+            imhui_gl->quad_vbo_capacity = imhui->quads_capacity;
+        }
+        glBufferSubData(
+            GL_ARRAY_BUFFER,
+            0,
+            imhui->quads_count * sizeof(imhui->quads[0]),
+            imhui->quads);
+
+        imhui_gl_draw_quad_batches(imhui_gl, imhui, 0);
+        return;
+    }
+
     glBindVertexArray(imhui_gl->vao);
     glBindBuffer(GL_ARRAY_BUFFER, imhui_gl->vert_vbo);
+    if (imhui->vertices_count > imhui_gl->vert_vbo_capacity) {
+        // NOTE: the VBO follows the capacity of ImHui vertices, so it is reallocated
+        // only as often as the CPU side buffer grows.
+        glBufferData(GL_ARRAY_BUFFER,
+                     imhui->vertices_capacity * sizeof(imhui->vertices[0]),
+                     NULL,
+                     GL_DYNAMIC_DRAW);
+        imhui_gl->vert_vbo_capacity = imhui->vertices_capacity;
+    }
     glBufferSubData(
         GL_ARRAY_BUFFER,
         0,
         imhui->vertices_count * sizeof(imhui->vertices[0]),
         imhui->vertices);
 
-    glDrawElements(GL_TRIANGLES,
-                   imhui->triangles_count * TRIANGLE_COUNT,
-                   GL_UNSIGNED_INT,
-                   imhui->triangles);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, imhui_gl->index_ebo);
+    if (imhui->triangles_count > imhui_gl->index_ebo_capacity) {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                     imhui->triangles_capacity * sizeof(imhui->triangles[0]),
+                     NULL,
+                     GL_DYNAMIC_DRAW);
+        imhui_gl->index_ebo_capacity = imhui->triangles_capacity;
+    }
+    glBufferSubData(
+        GL_ELEMENT_ARRAY_BUFFER,
+        0,
+        imhui->triangles_count * sizeof(imhui->triangles[0]),
+        imhui->triangles);
+
+    imhui_gl_draw_batches(imhui_gl, imhui, 0);
 }
 
+// Set whenever the already presented frame becomes invalid, so it must be
+// presented again even if ImHui did not produce anything new.
+bool redraw = true;
+
 void window_size_callback(GLFWwindow* window, int width, int height)
 {
     (void) window;
+    redraw = true;
     glViewport(
         width / 2 - DISPLAY_WIDTH / 2,
         height / 2 - DISPLAY_HEIGHT / 2,
@@ -244,11 +747,24 @@ void MessageCallback(GLenum source,
             type, severity, message);
 }
 
+ImHui_Input_Queue input = {0};
+
 ImHui imhui = {
     .width = DISPLAY_WIDTH,
     .height = DISPLAY_HEIGHT,
+    .vertex_cache = true,
+    .input = &input,
 };
 
+// NOTE: the moves are merged in the queue, so it only fills up with hundreds of clicks
+// and scrolls piled up within a single frame
+void push_input(ImHui_Input_Event event)
+{
+    if (!imhui_input_push(&input, event)) {
+        fprintf(stderr, "WARNING: the input queue is full, dropped an event of type %d\n", event.type);
+    }
+}
+
 void cursor_position_callback(GLFWwindow* window, double xpos, double ypos)
 {
     int width, height;
@@ -257,29 +773,126 @@ void cursor_position_callback(GLFWwindow* window, double xpos, double ypos)
     const double offset_x = width / 2 - DISPLAY_WIDTH / 2;
     const double offset_y = height / 2 - DISPLAY_HEIGHT / 2;
 
-    imhui_mouse_move(&imhui, xpos - offset_x, ypos - offset_y);
+    push_input((ImHui_Input_Event) {
+        .type = IMHUI_INPUT_MOUSE_MOVE,
+        .time = glfwGetTime(),
+        .pos = vec2(xpos - offset_x, ypos - offset_y),
+    });
+}
+
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    (void) window;
+    (void) xoffset;
+    push_input((ImHui_Input_Event) {
+        .type = IMHUI_INPUT_MOUSE_SCROLL,
+        .time = glfwGetTime(),
+        .dy = yoffset,
+    });
+}
+
+// Maps the whole file into memory. The pages are loaded by the OS only when
+// the text view touches them, so even huge logs open instantly.
+const char *map_file(const char *file_path, size_t *size)
+{
+    const int fd = open(file_path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: could not open file %s: %s\n", file_path, strerror(errno));
+        return NULL;
+    }
+
+    struct stat statbuf;
+    if (fstat(fd, &statbuf) < 0) {
+        fprintf(stderr, "ERROR: could not get the size of file %s: %s\n", file_path, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    *size = statbuf.st_size;
+    if (*size == 0) {
+        close(fd);
+        return "";
+    }
+
+    void *data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "ERROR: could not map file %s: %s\n", file_path, strerror(errno));
+        return NULL;
+    }
+
+    return data;
 }
 
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 {
+    (void) window;
     (void) mods;
-    if (button == GLFW_MOUSE_BUTTON_LEFT) {
-        if (action == GLFW_PRESS) {
-            double xpos, ypos;
-            glfwGetCursorPos(window, &xpos, &ypos);
-            imhui_mouse_down(&imhui);
+    // NOTE: a press and a release within the same frame are both queued, so imhui_begin()
+    // spreads them over two frames and the click is not lost.
+    if (button == GLFW_MOUSE_BUTTON_LEFT && (action == GLFW_PRESS || action == GLFW_RELEASE)) {
+        push_input((ImHui_Input_Event) {
+            .type = action == GLFW_PRESS ? IMHUI_INPUT_MOUSE_DOWN : IMHUI_INPUT_MOUSE_UP,
+            .time = glfwGetTime(),
+        });
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // NOTE: by default the main loop sleeps in glfwWaitEvents() while the UI does not change.
+    // --poll keeps it spinning, which is useful for profiling.
+    bool wait_events = true;
+    bool streaming = false;
+    const char *view_file_path = NULL;
+    const char *sdf_file_path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--poll") == 0) {
+            wait_events = false;
+        } else if (strcmp(argv[i], "--instanced") == 0) {
+            imhui.instanced = true;
+        } else if (strcmp(argv[i], "--atlas") == 0) {
+            imhui.atlas.rasterize = imhui_font_rasterize;
+        } else if (strcmp(argv[i], "--sdf") == 0 && i + 1 < argc) {
+            sdf_file_path = argv[++i];
+        } else if (strcmp(argv[i], "--streaming") == 0) {
+            streaming = true;
+        } else if (strcmp(argv[i], "--view") == 0 && i + 1 < argc) {
+            view_file_path = argv[++i];
+        } else {
+            fprintf(stderr, "ERROR: unknown flag `%s`\n", argv[i]);
+            fprintf(stderr, "Usage: %s [--poll] [--instanced] [--atlas] [--sdf <file>] [--streaming] [--view <file>]\n", argv[0]);
+            exit(1);
         }
+    }
 
-        if (action == GLFW_RELEASE) {
-            double xpos, ypos;
-            glfwGetCursorPos(window, &xpos, &ypos);
-            imhui_mouse_up(&imhui);
+    const char *view_data = NULL;
+    size_t view_size = 0;
+    ImHui_Line_Index view_index = {0};
+    float view_scroll = 0.0f;
+    if (view_file_path != NULL) {
+        view_data = map_file(view_file_path, &view_size);
+        if (view_data == NULL) {
+            exit(1);
         }
+        imhui_line_index_update(&imhui, &view_index, view_data, view_size);
+    }
+
+    const char *sdf_data = NULL;
+    size_t sdf_size = 0;
+    ImHui_Sdf_Font sdf = {0};
+    if (sdf_file_path != NULL) {
+        sdf_data = map_file(sdf_file_path, &sdf_size);
+        if (sdf_data == NULL) {
+            exit(1);
+        }
+        if (!imhui_sdf_load(&imhui, &sdf, sdf_data, sdf_size)) {
+            fprintf(stderr, "ERROR: %s is not a valid SDF font\n", sdf_file_path);
+            exit(1);
+        }
+        imhui.sdf = &sdf;
     }
-}
 
-int main()
-{
     if (!glfwInit()) {
         fprintf(stderr, "ERROR: could not initialize GLFW\n");
         exit(1);
@@ -314,12 +927,14 @@ int main()
     glfwSetFramebufferSizeCallback(window, window_size_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetCursorPosCallback(window, cursor_position_callback);
+    glfwSetScrollCallback(window, scroll_callback);
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     GLuint vert_shader = 0;
-    if (!compile_shader_source(vert_shader_source, GL_VERTEX_SHADER, &vert_shader)) {
+    if (!compile_shader_source(imhui.instanced ? quad_vert_shader_source : vert_shader_source,
+                               GL_VERTEX_SHADER, &vert_shader)) {
         exit(1);
     }
 
@@ -332,6 +947,22 @@ int main()
     if (!link_program(vert_shader, frag_shader, &program)) {
         exit(1);
     }
+
+    GLuint sdf_program = 0;
+    if (imhui.sdf != NULL) {
+        GLuint sdf_frag_shader = 0;
+        if (!compile_shader_source(sdf_frag_shader_source, GL_FRAGMENT_SHADER, &sdf_frag_shader)) {
+            exit(1);
+        }
+        if (!link_program(vert_shader, sdf_frag_shader, &sdf_program)) {
+            exit(1);
+        }
+        glUseProgram(sdf_program);
+        glUniform2f(glGetUniformLocation(sdf_program, "resolution"),
+                    (float) DISPLAY_WIDTH,
+                    (float) DISPLAY_HEIGHT);
+    }
+
     glUseProgram(program);
 
     GLuint resolutionUniform = glGetUniformLocation(program, "resolution");
@@ -339,37 +970,70 @@ int main()
                 (float) DISPLAY_WIDTH,
                 (float) DISPLAY_HEIGHT);
 
-    ImHui_GL imhui_gl = {0};
+    ImHui_GL imhui_gl = {
+        .streaming = streaming,
+        .program = program,
+        .sdf_program = sdf_program,
+    };
 
     imhui_gl_begin(&imhui_gl, &imhui);
 
     while (!glfwWindowShouldClose(window)) {
         const float PADDING = 10.0f;
         imhui_begin(&imhui, vec2(0.0f, 0.0f), PADDING);
+        imhui_layout_begin(&imhui, IMHUI_HORZ_LAYOUT, PADDING);
+        imhui_layout_begin(&imhui, IMHUI_VERT_LAYOUT, PADDING);
         {
             const size_t ROWS = 10;
             const size_t COLS = 5;
-            for (size_t i = 0; i < ROWS; ++i) {
-                imhui_layout_begin(&imhui, IMHUI_HORZ_LAYOUT, PADDING);
-                for (size_t j = 0; j < COLS; ++j) {
-                    ImHui_ID id = i * COLS + j + 1;
-                    if (imhui_button(&imhui, "Button", id)) {
-                        printf("Clicked button %d\n", id);
+            ImHui_Clipper clipper;
+            imhui_clipper_begin(&imhui, &clipper, ROWS, 0.0f);
+            while (imhui_clipper_step(&imhui, &clipper)) {
+                for (size_t i = clipper.first; i < clipper.last; ++i) {
+                    imhui_push_id_index(&imhui, i);
+                    imhui_layout_begin(&imhui, IMHUI_HORZ_LAYOUT, PADDING);
+                    for (size_t j = 0; j < COLS; ++j) {
+                        if (imhui_button(&imhui, "Button", imhui_id_index(&imhui, j))) {
+                            printf("Clicked button %zu of row %zu\n", j, i);
+                        }
                     }
+                    imhui_layout_end(&imhui);
+                    imhui_pop_id(&imhui);
                 }
-                imhui_layout_end(&imhui);
             }
         }
+        imhui_layout_end(&imhui);
+        if (view_data != NULL) {
+            imhui_text_view(&imhui, &view_index, vec2(DISPLAY_WIDTH - 570.0f, DISPLAY_HEIGHT - 20.0f), &view_scroll);
+        }
+        imhui_layout_end(&imhui);
         imhui_end(&imhui);
 
-        glClearColor(HEXCOLOR(BACKGROUND_COLOR_HEX));
-        glClear(GL_COLOR_BUFFER_BIT);
+        if (imhui.dirty || redraw) {
+            glClearColor(HEXCOLOR(BACKGROUND_COLOR_HEX));
+            glClear(GL_COLOR_BUFFER_BIT);
 
-        imhui_gl_render(&imhui_gl, &imhui);
+            imhui_gl_render(&imhui_gl, &imhui);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+            glfwSwapBuffers(window);
+            redraw = false;
+            glfwPollEvents();
+        } else if (wait_events && !imhui_input_pending(&input)) {
+            glfwWaitEvents();
+        } else {
+            glfwPollEvents();
+        }
+    }
+
+    if (view_size > 0) {
+        munmap((void*) view_data, view_size);
+    }
+    imhui_line_index_free(&imhui, &view_index);
+    imhui_sdf_free(&imhui, &sdf);
+    if (sdf_size > 0) {
+        munmap((void*) sdf_data, sdf_size);
     }
+    imhui_free(&imhui);
 
     return 0;
 }
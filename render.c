@@ -0,0 +1,215 @@
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define IMHUI_IMPLEMENTATION
+#include "imhui.h"
+
+#define IMHUI_SOFT_IMPLEMENTATION
+#include "imhui_soft.h"
+
+#define DISPLAY_WIDTH 800
+#define DISPLAY_HEIGHT 600
+
+static ImHui_Line_Index view_index = {0};
+static float view_scroll = 0.0f;
+
+// The same UI as the one of main.c
+static void render_frame(ImHui *imhui)
+{
+    const float PADDING = 10.0f;
+    imhui_begin(imhui, vec2(0.0f, 0.0f), PADDING);
+    imhui_layout_begin(imhui, IMHUI_HORZ_LAYOUT, PADDING);
+    imhui_layout_begin(imhui, IMHUI_VERT_LAYOUT, PADDING);
+    {
+        const size_t ROWS = 10;
+        const size_t COLS = 5;
+        ImHui_Clipper clipper;
+        imhui_clipper_begin(imhui, &clipper, ROWS, 0.0f);
+        while (imhui_clipper_step(imhui, &clipper)) {
+            for (size_t i = clipper.first; i < clipper.last; ++i) {
+                imhui_push_id_index(imhui, i);
+                imhui_layout_begin(imhui, IMHUI_HORZ_LAYOUT, PADDING);
+                for (size_t j = 0; j < COLS; ++j) {
+                    imhui_button(imhui, "Button", imhui_id_index(imhui, j));
+                }
+                imhui_layout_end(imhui);
+                imhui_pop_id(imhui);
+            }
+        }
+    }
+    imhui_layout_end(imhui);
+    if (view_index.data != NULL) {
+        imhui_text_view(imhui, &view_index, vec2(DISPLAY_WIDTH - 570.0f, DISPLAY_HEIGHT - 20.0f), &view_scroll);
+    }
+    imhui_layout_end(imhui);
+    imhui_end(imhui);
+}
+
+static double render_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+static bool render_has_suffix(const char *s, const char *suffix)
+{
+    const size_t n = strlen(s);
+    const size_t m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+static char *render_read_file(const char *file_path, size_t *size)
+{
+    FILE *f = fopen(file_path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "ERROR: could not open file %s: %s\n", file_path, strerror(errno));
+        return NULL;
+    }
+
+    char *data = NULL;
+    *size = 0;
+    size_t capacity = 0;
+    for (;;) {
+        if (*size == capacity) {
+            capacity = capacity == 0 ? 4096 : capacity * 2;
+            data = realloc(data, capacity);
+            assert(data != NULL);
+        }
+        const size_t n = fread(data + *size, 1, capacity - *size, f);
+        if (n == 0) {
+            break;
+        }
+        *size += n;
+    }
+
+    if (ferror(f)) {
+        fprintf(stderr, "ERROR: could not read file %s: %s\n", file_path, strerror(errno));
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [--instanced] [--atlas] [--sdf <file>] [--threads N] [--frames N] [--mouse X Y] [--down] [--view <file>] [--scroll PIXELS] <output.png|output.ppm>\n", program);
+}
+
+int main(int argc, char **argv)
+{
+    ImHui imhui = {
+        .width = DISPLAY_WIDTH,
+        .height = DISPLAY_HEIGHT,
+    };
+    ImHui_Soft soft = {
+        .width = DISPLAY_WIDTH,
+        .height = DISPLAY_HEIGHT,
+    };
+    size_t frames = 1;
+    bool down = false;
+    const char *output_path = NULL;
+    char *view_data = NULL;
+    char *sdf_data = NULL;
+    ImHui_Sdf_Font sdf = {0};
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--instanced") == 0) {
+            imhui.instanced = true;
+        } else if (strcmp(argv[i], "--atlas") == 0) {
+            imhui.atlas.rasterize = imhui_font_rasterize;
+        } else if (strcmp(argv[i], "--sdf") == 0 && i + 1 < argc) {
+            const char *sdf_path = argv[++i];
+            size_t sdf_size = 0;
+            sdf_data = render_read_file(sdf_path, &sdf_size);
+            if (sdf_data == NULL) {
+                exit(1);
+            }
+            if (!imhui_sdf_load(&imhui, &sdf, sdf_data, sdf_size)) {
+                fprintf(stderr, "ERROR: %s is not a valid SDF font\n", sdf_path);
+                exit(1);
+            }
+            imhui.sdf = &sdf;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            soft.threads = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--mouse") == 0 && i + 2 < argc) {
+            const float x = strtof(argv[i + 1], NULL);
+            const float y = strtof(argv[i + 2], NULL);
+            imhui_mouse_move(&imhui, x, y);
+            i += 2;
+        } else if (strcmp(argv[i], "--down") == 0) {
+            down = true;
+        } else if (strcmp(argv[i], "--view") == 0 && i + 1 < argc) {
+            size_t view_size = 0;
+            view_data = render_read_file(argv[++i], &view_size);
+            if (view_data == NULL) {
+                exit(1);
+            }
+            imhui_line_index_update(&imhui, &view_index, view_data, view_size);
+        } else if (strcmp(argv[i], "--scroll") == 0 && i + 1 < argc) {
+            view_scroll = strtof(argv[++i], NULL);
+        } else if (output_path == NULL && argv[i][0] != '-') {
+            output_path = argv[i];
+        } else {
+            fprintf(stderr, "ERROR: unknown flag `%s`\n", argv[i]);
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+
+    if (output_path == NULL || frames == 0) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    soft.pixels = malloc(sizeof(*soft.pixels) * soft.width * soft.height);
+    assert(soft.pixels != NULL);
+
+    // NOTE: the first frame only figures out which button is hot, the same way it
+    // takes a frame in the GUI before the button under the cursor lights up.
+    render_frame(&imhui);
+    if (down) {
+        imhui_mouse_down(&imhui);
+        render_frame(&imhui);
+    }
+
+    double total_ns = 0.0;
+    for (size_t i = 0; i < frames; ++i) {
+        render_frame(&imhui);
+
+        const double begin = render_now_ns();
+        imhui_soft_clear(&soft, rgba(HEXCOLOR(BACKGROUND_COLOR_HEX)));
+        imhui_soft_render(&soft, &imhui);
+        total_ns += render_now_ns() - begin;
+    }
+    printf("Rasterized %zux%zu in %.3f ms per frame (%zu thread(s))\n",
+           soft.width, soft.height, total_ns / (double) frames / 1e6,
+           soft.threads > 1 ? soft.threads : 1);
+
+    const bool ok = render_has_suffix(output_path, ".ppm")
+                    ? imhui_soft_save_ppm(&soft, output_path)
+                    : imhui_soft_save_png(&soft, output_path);
+    if (!ok) {
+        exit(1);
+    }
+    printf("Generated %s\n", output_path);
+
+    imhui_soft_free(&soft);
+    free(soft.pixels);
+    imhui_line_index_free(&imhui, &view_index);
+    free(view_data);
+    imhui_sdf_free(&imhui, &sdf);
+    free(sdf_data);
+    imhui_free(&imhui);
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IMHUI_IMPLEMENTATION
+#include "imhui.h"
+
+// Offline generator of the signed distance field font of imhui.h out of the built-in
+// bitmap FONT. Every pixel of FONT becomes `scale` x `scale` texels of the field, so
+// the edges of the glyphs stay sharp at any size the field is drawn at.
+
+#define SDFGEN_FIRST 32
+#define SDFGEN_COUNT (FONT_SOLID_CHAR - SDFGEN_FIRST)
+#define SDFGEN_COLUMNS 16
+
+static bool sdfgen_font_pixel(size_t index, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= FONT_CHAR_WIDTH || y >= FONT_CHAR_HEIGHT) {
+        return false;
+    }
+    const size_t gx = index % FONT_COLS * FONT_CHAR_WIDTH;
+    const size_t gy = index / FONT_COLS * FONT_CHAR_HEIGHT;
+    return FONT[(gy + y) * FONT_WIDTH + gx + x] != 0;
+}
+
+// The distance in the pixels of FONT from (px, py) to the nearest pixel that is
+// `inside` or not, with everything beyond the cell being outside.
+// NOTE: brute force, there are only a few dozens of pixels in a glyph.
+static float sdfgen_distance(size_t index, float px, float py, bool inside)
+{
+    float best = INFINITY;
+    for (int y = -1; y <= FONT_CHAR_HEIGHT; ++y) {
+        for (int x = -1; x <= FONT_CHAR_WIDTH; ++x) {
+            if (sdfgen_font_pixel(index, x, y) != inside) {
+                continue;
+            }
+            const float dx = fmaxf(fmaxf((float) x - px, 0.0f), px - (float) (x + 1));
+            const float dy = fmaxf(fmaxf((float) y - py, 0.0f), py - (float) (y + 1));
+            best = fminf(best, dx * dx + dy * dy);
+        }
+    }
+    return sqrtf(best);
+}
+
+static void sdfgen_put_u32_le(uint8_t *p, uint32_t x)
+{
+    p[0] = (uint8_t) (x & 0xFF);
+    p[1] = (uint8_t) ((x >> 8) & 0xFF);
+    p[2] = (uint8_t) ((x >> 16) & 0xFF);
+    p[3] = (uint8_t) ((x >> 24) & 0xFF);
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [--scale N] [--spread TEXELS] <output.sdf>\n", program);
+}
+
+int main(int argc, char **argv)
+{
+    size_t scale = 4;
+    size_t spread = 4;
+    const char *output_path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--spread") == 0 && i + 1 < argc) {
+            spread = strtoul(argv[++i], NULL, 10);
+        } else if (output_path == NULL && argv[i][0] != '-') {
+            output_path = argv[i];
+        } else {
+            fprintf(stderr, "ERROR: unknown flag `%s`\n", argv[i]);
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+
+    if (output_path == NULL || scale == 0 || spread == 0) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    // NOTE: the padding is as wide as the spread, so the filtering of the edge
+    // texels of a cell never picks up the field of its neighbours.
+    const size_t padding = spread;
+    const size_t cell_width = FONT_CHAR_WIDTH * scale;
+    const size_t cell_height = FONT_CHAR_HEIGHT * scale;
+    const size_t stride_x = cell_width + 2 * padding;
+    const size_t stride_y = cell_height + 2 * padding;
+    const size_t rows = (SDFGEN_COUNT + 1 + SDFGEN_COLUMNS - 1) / SDFGEN_COLUMNS;
+    const size_t width = SDFGEN_COLUMNS * stride_x;
+    const size_t height = rows * stride_y;
+
+    const size_t size = IMHUI_SDF_HEADER_SIZE + width * height;
+    uint8_t *data = calloc(size, 1);
+    assert(data != NULL);
+
+    memcpy(data, IMHUI_SDF_MAGIC, 4);
+    const uint32_t fields[10] = {
+        IMHUI_SDF_VERSION,
+        (uint32_t) width,
+        (uint32_t) height,
+        (uint32_t) cell_width,
+        (uint32_t) cell_height,
+        (uint32_t) padding,
+        (uint32_t) spread,
+        SDFGEN_FIRST,
+        SDFGEN_COUNT,
+        SDFGEN_COLUMNS,
+    };
+    for (size_t i = 0; i < 10; ++i) {
+        sdfgen_put_u32_le(data + 4 + 4 * i, fields[i]);
+    }
+
+    uint8_t *pixels = data + IMHUI_SDF_HEADER_SIZE;
+    for (size_t i = 0; i <= SDFGEN_COUNT; ++i) {
+        const size_t cx = i % SDFGEN_COLUMNS * stride_x;
+        const size_t cy = i / SDFGEN_COLUMNS * stride_y;
+
+        // NOTE: the solid rect is inside everywhere, even in the padding,
+        // so the rects sampled anywhere within the cell are fully opaque.
+        if (i == SDFGEN_COUNT) {
+            for (size_t y = 0; y < stride_y; ++y) {
+                memset(&pixels[(cy + y) * width + cx], 0xFF, stride_x);
+            }
+            continue;
+        }
+
+        const size_t index = SDFGEN_FIRST + i - 32;
+        for (size_t y = 0; y < stride_y; ++y) {
+            for (size_t x = 0; x < stride_x; ++x) {
+                // The center of the texel in the pixels of FONT
+                const float px = ((float) x - (float) padding + 0.5f) / (float) scale;
+                const float py = ((float) y - (float) padding + 0.5f) / (float) scale;
+                const bool inside = px >= 0.0f && py >= 0.0f &&
+                                    sdfgen_font_pixel(index, (int) px, (int) py);
+                const float distance = sdfgen_distance(index, px, py, !inside) * (float) scale;
+                const float d = 0.5f + (inside ? distance : -distance) / (2.0f * (float) spread);
+                pixels[(cy + y) * width + cx + x] = (uint8_t) (fminf(fmaxf(d, 0.0f), 1.0f) * 255.0f + 0.5f);
+            }
+        }
+    }
+
+    FILE *f = fopen(output_path, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "ERROR: could not open file %s: %s\n", output_path, strerror(errno));
+        exit(1);
+    }
+    fwrite(data, 1, size, f);
+    if (ferror(f)) {
+        fprintf(stderr, "ERROR: could not write file %s: %s\n", output_path, strerror(errno));
+        exit(1);
+    }
+    fclose(f);
+    printf("Generated %s: %zux%zu texels, %zu glyphs\n", output_path, width, height, (size_t) SDFGEN_COUNT);
+
+    free(data);
+    return 0;
+}